@@ -0,0 +1,346 @@
+"""Run the C++ and Python benchmarks and compare results against a baseline.
+
+Results of both suites are normalized to the median time per benchmark, in
+seconds, and written to a single JSON file.  Compared to a baseline, any
+benchmark slower by more than the threshold is a regression, as is any
+benchmark that failed or is missing from the current results, and the script
+exits with status 1.
+
+Baselines are specific to the machine they were recorded on; record one before
+changing maplibre-native or the wrapper, then compare after.
+
+To record a baseline:
+
+    python benchmarks/compare.py run --save benchmarks/baseline.json
+
+To compare against it:
+
+    python benchmarks/compare.py run --baseline benchmarks/baseline.json
+
+To compare existing results:
+
+    python benchmarks/compare.py compare benchmarks/baseline.json results.json
+"""
+
+import argparse
+import json
+import os
+from pathlib import Path
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+ROOT = Path(__file__).resolve().parent.parent
+
+XVFB_ARGS = [
+    "xvfb-run",
+    "-a",
+    "--server-args=-screen 0 1024x768x24 -ac +render -noreset",
+]
+
+# Google Benchmark time units, in seconds
+TIME_UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1}
+
+
+def read_cpp_results(path):
+    """Return median time in seconds by benchmark name from Google Benchmark JSON,
+    and error messages by name of benchmarks that failed"""
+    with open(path) as f:
+        data = json.load(f)
+
+    times = {}
+    medians = {}
+    errors = {}
+    for benchmark in data["benchmarks"]:
+        name = benchmark.get("run_name", benchmark["name"])
+        if benchmark.get("error_occurred"):
+            errors[f"cpp::{name}"] = benchmark.get("error_message", "error")
+            continue
+
+        time = benchmark["real_time"] * TIME_UNITS[benchmark.get("time_unit", "ns")]
+
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[name] = time
+        else:
+            times.setdefault(name, []).append(time)
+
+    results = {name: median(values) for name, values in times.items()}
+    results.update(medians)
+
+    return {f"cpp::{name}": time for name, time in results.items()}, errors
+
+
+def read_python_results(path):
+    """Return median time in seconds by benchmark name from pytest-benchmark JSON"""
+    with open(path) as f:
+        data = json.load(f)
+
+    return {
+        f"python::{benchmark['fullname']}": benchmark["stats"]["median"]
+        for benchmark in data["benchmarks"]
+    }
+
+
+def median(values):
+    values = sorted(values)
+    mid = len(values) // 2
+    if len(values) % 2:
+        return values[mid]
+    return (values[mid - 1] + values[mid]) / 2
+
+
+def use_xvfb(option):
+    if option == "auto":
+        return (
+            sys.platform.startswith("linux")
+            and not os.getenv("DISPLAY")
+            and shutil.which("xvfb-run") is not None
+        )
+    return option == "always"
+
+
+def run(args):
+    prefix = XVFB_ARGS if use_xvfb(args.xvfb) else []
+    results = {}
+    errors = {}
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        if not args.skip_cpp:
+            bench = Path(args.bench)
+            if not bench.exists():
+                sys.exit(
+                    f"{bench} not found; build it with "
+                    "'cmake --build build --target pymgl_bench' or pass --skip-cpp"
+                )
+
+            out = Path(tmpdir) / "cpp.json"
+            cmd = prefix + [
+                str(bench.resolve()),
+                f"--benchmark_out={out}",
+                "--benchmark_out_format=json",
+                f"--benchmark_repetitions={args.repetitions}",
+                "--benchmark_report_aggregates_only=true",
+            ]
+            if args.filter:
+                cmd.append(f"--benchmark_filter={args.filter}")
+
+            # fixtures are found relative to the root directory; results of
+            # benchmarks that completed are kept if others crash
+            if subprocess.run(cmd, cwd=ROOT).returncode:
+                errors["cpp"] = "pymgl_bench exited with an error"
+            if out.exists():
+                times, failed = read_cpp_results(out)
+                results.update(times)
+                errors.update(failed)
+
+        if not args.skip_python:
+            out = Path(tmpdir) / "python.json"
+            cmd = prefix + [
+                sys.executable,
+                "-m",
+                "pytest",
+                "benchmarks",
+                "--offline",
+                "--benchmark-only",
+                f"--benchmark-json={out}",
+            ]
+            if args.filter:
+                cmd.extend(["-k", args.filter])
+
+            # failed tests are not included in the results
+            if subprocess.run(cmd, cwd=ROOT).returncode:
+                errors["python"] = "pytest exited with an error"
+            if out.exists():
+                results.update(read_python_results(out))
+
+    output = {
+        "machine": {
+            "node": platform.node(),
+            "system": platform.system(),
+            "processor": platform.processor() or platform.machine(),
+            "cpus": os.cpu_count(),
+        },
+        "benchmarks": results,
+        "errors": errors,
+    }
+
+    if args.save:
+        write_results(output, args.save)
+
+    if args.baseline:
+        return compare(
+            load_results(args.baseline), output, args.threshold, args.allow_missing
+        )
+
+    for name, message in errors.items():
+        print(f"ERROR: {name}: {message}", file=sys.stderr)
+
+    return 1 if errors else 0
+
+
+def write_results(results, path):
+    with open(path, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+
+
+def load_results(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def format_time(seconds):
+    for unit, scale in (("s", 1), ("ms", 1e-3), ("us", 1e-6)):
+        if seconds >= scale:
+            return f"{seconds / scale:.2f} {unit}"
+    return f"{seconds / 1e-9:.0f} ns"
+
+
+def compare(baseline, current, threshold, allow_missing=False):
+    """Print a table comparing current to baseline results and return 1 if any
+    benchmark regressed by more than threshold percent, failed, or is missing
+    from current results unless allow_missing"""
+    if baseline.get("machine") != current.get("machine"):
+        print(
+            "WARNING: baseline was recorded on a different machine:",
+            baseline.get("machine"),
+            file=sys.stderr,
+        )
+
+    before = baseline["benchmarks"]
+    after = current["benchmarks"]
+    errors = current.get("errors", {})
+    names = sorted(set(before) | set(after) | set(errors))
+    width = max([len(name) for name in names] + [9])
+
+    print(
+        f"{'benchmark':<{width}}  {'baseline':>10}  {'current':>10}  {'change':>8}  status"
+    )
+    print("-" * (width + 46))
+
+    regressions = 0
+    failures = 0
+    for name in names:
+        baseline_time = format_time(before[name]) if name in before else ""
+        if name in errors:
+            print(f"{name:<{width}}  {baseline_time:>10}  {'':>10}  {'':>8}  FAILED")
+            print(f"    {errors[name]}")
+            failures += 1
+            continue
+        if name not in after:
+            status = "missing" if allow_missing else "MISSING"
+            print(f"{name:<{width}}  {baseline_time:>10}  {'':>10}  {'':>8}  {status}")
+            if not allow_missing:
+                failures += 1
+            continue
+        if name not in before:
+            print(f"{name:<{width}}  {'':>10}  {format_time(after[name]):>10}  {'':>8}  new")
+            continue
+
+        change = 100 * (after[name] - before[name]) / before[name]
+        if change > threshold:
+            status = "REGRESSED"
+            regressions += 1
+        elif change < -threshold:
+            status = "improved"
+        else:
+            status = "ok"
+
+        print(
+            f"{name:<{width}}  {format_time(before[name]):>10}  "
+            f"{format_time(after[name]):>10}  {change:>+7.1f}%  {status}"
+        )
+
+    print()
+    if failures:
+        print(f"{failures} benchmark(s) or suite(s) failed or are missing")
+    if regressions:
+        print(f"{regressions} benchmark(s) regressed by more than {threshold}%")
+    if failures or regressions:
+        return 1
+
+    print(f"No benchmarks regressed by more than {threshold}%")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    run_parser = subparsers.add_parser(
+        "run", help="run benchmarks, then save and / or compare results"
+    )
+    run_parser.add_argument(
+        "--bench",
+        default=str(ROOT / "build/tests/pymgl_bench"),
+        help="path to the pymgl_bench executable (default: build/tests/pymgl_bench)",
+    )
+    run_parser.add_argument("--skip-cpp", action="store_true", help="skip C++ benchmarks")
+    run_parser.add_argument(
+        "--skip-python", action="store_true", help="skip Python benchmarks"
+    )
+    run_parser.add_argument(
+        "--filter",
+        help="only run benchmarks matching this filter; a regex for C++ and a -k expression for Python",
+    )
+    run_parser.add_argument(
+        "--repetitions",
+        type=int,
+        default=5,
+        help="repetitions of each C++ benchmark; the median is compared (default: 5)",
+    )
+    run_parser.add_argument(
+        "--xvfb",
+        choices=["auto", "always", "never"],
+        default="auto",
+        help="run benchmarks under xvfb-run; auto uses it on Linux if DISPLAY is not set",
+    )
+    run_parser.add_argument(
+        "--allow-missing",
+        action="store_true",
+        help="do not fail on baseline benchmarks that did not run, as with --filter",
+    )
+    run_parser.add_argument("--save", help="write results to this JSON file")
+    run_parser.add_argument("--baseline", help="compare results to this JSON file")
+    run_parser.add_argument(
+        "--threshold",
+        type=float,
+        default=10,
+        help="percent slowdown that is a regression (default: 10)",
+    )
+
+    compare_parser = subparsers.add_parser(
+        "compare", help="compare results saved by run --save"
+    )
+    compare_parser.add_argument("baseline", help="baseline results JSON file")
+    compare_parser.add_argument("current", help="current results JSON file")
+    compare_parser.add_argument(
+        "--allow-missing",
+        action="store_true",
+        help="do not fail on baseline benchmarks that did not run, as with --filter",
+    )
+    compare_parser.add_argument(
+        "--threshold",
+        type=float,
+        default=10,
+        help="percent slowdown that is a regression (default: 10)",
+    )
+
+    args = parser.parse_args()
+
+    if args.command == "run":
+        return run(args)
+
+    return compare(
+        load_results(args.baseline),
+        load_results(args.current),
+        args.threshold,
+        args.allow_missing,
+    )
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,26 @@
+import pytest
+
+
+def pytest_addoption(parser):
+    parser.addoption(
+        "--offline",
+        action="store_true",
+        default=False,
+        help="skip benchmarks that require a network connection",
+    )
+
+
+def pytest_configure(config):
+    config.addinivalue_line(
+        "markers", "network: benchmark requires a network connection"
+    )
+
+
+def pytest_collection_modifyitems(config, items):
+    if not config.getoption("--offline"):
+        return
+
+    skip_network = pytest.mark.skip(reason="requires a network connection")
+    for item in items:
+        if "network" in item.keywords:
+            item.add_marker(skip_network)
@@ -0,0 +1,63 @@
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "map.h"
+#include "util.h"
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+// Benchmarks are named BM_<group name><benchmark name>
+
+static void BM_MapConstructEmpty(benchmark::State &state) {
+    for (auto _ : state) {
+        Map map = Map("", 256, 256);
+        benchmark::DoNotOptimize(map.getZoom());
+    }
+}
+BENCHMARK(BM_MapConstructEmpty)->Unit(benchmark::kMillisecond);
+
+static void BM_MapConstruct(benchmark::State &state) {
+    const string style = read_style("example-style-geojson.json");
+    for (auto _ : state) {
+        Map map = Map(style, 256, 256);
+        benchmark::DoNotOptimize(map.getZoom());
+    }
+}
+BENCHMARK(BM_MapConstruct)->Unit(benchmark::kMillisecond);
+
+static void BM_MapConstructTemplate(benchmark::State &state) {
+    auto style = make_shared<StyleTemplate>(read_style("example-style-geojson.json"));
+    for (auto _ : state) {
+        Map map = Map(style, 256, 256);
+        benchmark::DoNotOptimize(map.getZoom());
+    }
+}
+BENCHMARK(BM_MapConstructTemplate)->Unit(benchmark::kMillisecond);
+
+// Alternate between two styles so that each iteration changes the style;
+// range(0) is 1 to apply styles as a diff.
+static void BM_MapSetStyle(benchmark::State &state) {
+    const string styles[] = {read_style("example-style-geojson.json"),
+                             read_style("example-style-geojson-hidden-box.json")};
+    const bool diff       = state.range(0) == 1;
+
+    Map map = Map(styles[0], 256, 256);
+    map.render();
+
+    size_t i = 0;
+    for (auto _ : state) {
+        map.setStyle(styles[++i % 2], diff);
+    }
+}
+BENCHMARK(BM_MapSetStyle)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_MapValidateStyle(benchmark::State &state) {
+    const string style = read_style("example-style-geojson-labels.json");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validateStyle(style));
+    }
+}
+BENCHMARK(BM_MapValidateStyle)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,87 @@
+#include <regex>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <mbgl/util/image.hpp>
+
+#include "map.h"
+#include "util.h"
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+// Benchmarks are named BM_<group name><benchmark name>; range(0) is the
+// width and height of the map in pixels.
+
+static string local_style() {
+    // update style from relative to mbtiles_path to absolute
+    string style = read_style("example-style-mbtiles-vector-source.json");
+    return regex_replace(style, regex("mbtiles://"), "mbtiles://" + FIXTURES_PATH);
+}
+
+static void BM_Render(benchmark::State &state) {
+    const uint32_t size = state.range(0);
+    Map map             = Map(local_style(), size, size);
+
+    // load tiles before timing renders
+    map.render();
+    for (auto _ : state) {
+        map.render();
+    }
+}
+BENCHMARK(BM_Render)->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+
+static void BM_RenderBuffer(benchmark::State &state) {
+    const uint32_t size = state.range(0);
+    Map map             = Map(local_style(), size, size);
+
+    map.render();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.renderBuffer());
+    }
+}
+BENCHMARK(BM_RenderBuffer)->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+
+static void BM_RenderPNG(benchmark::State &state) {
+    const uint32_t size = state.range(0);
+    Map map             = Map(local_style(), size, size);
+
+    map.render();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.renderPNG());
+    }
+}
+BENCHMARK(BM_RenderPNG)->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+
+static void BM_RenderUnpremultiply(benchmark::State &state) {
+    const uint32_t size = state.range(0);
+    Map map             = Map(local_style(), size, size);
+
+    // only the unpremultiply phase of each render is timed, so that it is
+    // measured on the premultiplied frame read back from the renderer
+    map.render();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.renderBuffer());
+        state.SetIterationTime(map.getStats().last.unpremultiply / 1000);
+    }
+    state.SetBytesProcessed(state.iterations() * uint64_t(size) * size * 4);
+}
+BENCHMARK(BM_RenderUnpremultiply)
+    ->RangeMultiplier(2)
+    ->Range(256, 2048)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_RenderEncodePNG(benchmark::State &state) {
+    const uint32_t size = state.range(0);
+    Map map             = Map(local_style(), size, size);
+    auto pixels         = map.renderBuffer();
+    const mbgl::UnassociatedImage image({size, size}, pixels.get(), size * size * 4);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encodePNG(image));
+    }
+    state.SetBytesProcessed(state.iterations() * image.bytes());
+}
+BENCHMARK(BM_RenderEncodePNG)->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
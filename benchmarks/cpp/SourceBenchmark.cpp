@@ -0,0 +1,52 @@
+#include <sstream>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "map.h"
+#include "util.h"
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+// Benchmarks are named BM_<group name><benchmark name>
+
+// Return a GeoJSON FeatureCollection of count points in a grid
+static string make_points(int64_t count) {
+    ostringstream out;
+    out << R"({"type": "FeatureCollection", "features": [)";
+    for (int64_t i = 0; i < count; i++) {
+        if (i > 0) {
+            out << ",";
+        }
+        out << R"({"type": "Feature", "id": )" << i << R"(, "properties": {"value": )" << i
+            << R"(}, "geometry": {"type": "Point", "coordinates": [)" << (i % 360) - 180 << ", "
+            << (i / 360) % 170 - 85 << "]}}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+static void BM_SourceSetGeoJSON(benchmark::State &state) {
+    const string geoJSON = make_points(state.range(0));
+
+    Map map = Map(read_style("example-style-geojson.json"), 256, 256);
+    for (auto _ : state) {
+        map.setGeoJSON("geojson", geoJSON);
+    }
+    state.SetBytesProcessed(state.iterations() * geoJSON.size());
+}
+BENCHMARK(BM_SourceSetGeoJSON)->Range(100, 100000)->Unit(benchmark::kMillisecond);
+
+static void BM_SourceSetFeatureState(benchmark::State &state) {
+    Map map = Map(read_style("example-style-geojson-features.json"), 256, 256);
+    map.load();
+
+    bool value = false;
+    for (auto _ : state) {
+        map.setFeatureState("geojson", "box", "0", value ? R"({"a": true})" : R"({"a": false})");
+        value = !value;
+    }
+}
+BENCHMARK(BM_SourceSetFeatureState)->Unit(benchmark::kMicrosecond);
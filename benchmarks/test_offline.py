@@ -0,0 +1,263 @@
+"""Benchmarks that only use local fixtures and generated data, so that results
+are reproducible without a network connection.
+
+To run and save results as JSON:
+
+    pytest benchmarks/test_offline.py --benchmark-json=results.json
+"""
+
+from concurrent.futures import ThreadPoolExecutor
+import json
+import math
+import os
+
+import pytest
+
+from pymgl import Map
+
+from pymgl.tests.common import FIXTURES_PATH, read_style
+
+
+# Glyphs are not included in the fixtures; set to a file:// URL template for
+# local glyphs (e.g., file:///fonts/{fontstack}/{range}.pbf) to also benchmark
+# text labels.
+GLYPHS_URL = os.getenv("PYMGL_BENCH_GLYPHS", None)
+
+# 16 x 16 red square, as RGBA bytes
+MARKER = b"\xff\x00\x00\xff" * 16 * 16
+
+
+def mbtiles_style(filename):
+    # update style from relative to absolute path
+    return read_style(filename).replace("mbtiles://", f"mbtiles://{FIXTURES_PATH}/")
+
+
+def geojson_style(layers, glyphs=None):
+    style = {
+        "version": 8,
+        "sources": {
+            "geojson": {
+                "type": "geojson",
+                "data": {"type": "FeatureCollection", "features": []},
+            }
+        },
+        "layers": layers,
+    }
+    if glyphs:
+        style["glyphs"] = glyphs
+
+    return json.dumps(style)
+
+
+def make_points(count):
+    """Return a GeoJSON FeatureCollection of count points spread over the world"""
+    side = math.ceil(math.sqrt(count))
+    features = []
+    for i in range(count):
+        lon = -179 + 358 * (i % side) / side
+        lat = -80 + 160 * (i // side) / side
+        features.append(
+            {
+                "type": "Feature",
+                "id": i,
+                "properties": {"id": i, "label": f"Point {i}"},
+                "geometry": {"type": "Point", "coordinates": [lon, lat]},
+            }
+        )
+
+    return json.dumps({"type": "FeatureCollection", "features": features})
+
+
+def make_polygons(count, vertices=64):
+    """Return a GeoJSON FeatureCollection of count circular polygons"""
+    side = math.ceil(math.sqrt(count))
+    radius = 150 / side
+    features = []
+    for i in range(count):
+        x = -179 + 358 * (i % side) / side
+        y = -80 + 160 * (i // side) / side
+        ring = [
+            [
+                x + radius * math.cos(2 * math.pi * j / vertices),
+                y + radius * math.sin(2 * math.pi * j / vertices),
+            ]
+            for j in range(vertices)
+        ]
+        ring.append(ring[0])
+        features.append(
+            {
+                "type": "Feature",
+                "properties": {"id": i},
+                "geometry": {"type": "Polygon", "coordinates": [ring]},
+            }
+        )
+
+    return json.dumps({"type": "FeatureCollection", "features": features})
+
+
+def tile_center(z, x, y):
+    n = 2**z
+    lon = (x + 0.5) / n * 360 - 180
+    lat = math.degrees(math.atan(math.sinh(math.pi * (1 - 2 * (y + 0.5) / n))))
+    return lon, lat
+
+
+def render_pyramid(style, maxzoom):
+    # a 512 pixel map at zoom z covers the same area as a 256 pixel tile at z
+    with Map(style, 512, 512) as map:
+        for z in range(maxzoom + 1):
+            for x in range(2**z):
+                for y in range(2**z):
+                    map.setZoom(z)
+                    map.setCenter(*tile_center(z, x, y))
+                    map.renderPNG()
+
+
+def render_geojson(style, geojson, width, height):
+    with Map(style, width, height) as map:
+        map.setGeoJSON("geojson", geojson)
+        map.renderPNG()
+
+
+def render_many(style, width, height, count):
+    for _ in range(count):
+        with Map(style, width, height) as map:
+            map.renderPNG()
+
+
+def render_concurrent(style, threads, count):
+    # each thread creates and renders its own maps; the GIL is released while
+    # rendering
+    with ThreadPoolExecutor(max_workers=threads) as executor:
+        futures = [
+            executor.submit(render_many, style, 512, 512, count // threads)
+            for _ in range(threads)
+        ]
+        for future in futures:
+            future.result()
+
+
+@pytest.mark.benchmark(group="offline-pyramid-vector")
+@pytest.mark.parametrize("maxzoom", [2, 3])
+def test_pyramid_mbtiles_vector(benchmark, maxzoom):
+    style = mbtiles_style("example-style-mbtiles-vector-source.json")
+    benchmark.pedantic(render_pyramid, args=(style, maxzoom), rounds=3)
+
+
+@pytest.mark.benchmark(group="offline-pyramid-raster")
+def test_pyramid_mbtiles_raster(benchmark):
+    style = mbtiles_style("example-style-mbtiles-raster-source.json")
+    benchmark.pedantic(render_pyramid, args=(style, 1), rounds=5)
+
+
+@pytest.mark.benchmark(group="offline-geojson-points")
+@pytest.mark.parametrize("count", [1000, 10000, 100000])
+def test_large_geojson_points(benchmark, count):
+    style = geojson_style(
+        [
+            {
+                "id": "points",
+                "type": "circle",
+                "source": "geojson",
+                "paint": {"circle-radius": 2, "circle-color": "#FF0000"},
+            }
+        ]
+    )
+    benchmark.pedantic(
+        render_geojson, args=(style, make_points(count), 1024, 1024), rounds=3
+    )
+
+
+@pytest.mark.benchmark(group="offline-geojson-polygons")
+@pytest.mark.parametrize("count", [100, 1000, 10000])
+def test_large_geojson_polygons(benchmark, count):
+    style = geojson_style(
+        [
+            {
+                "id": "fill",
+                "type": "fill",
+                "source": "geojson",
+                "paint": {"fill-color": "#0000FF", "fill-opacity": 0.5},
+            },
+            {
+                "id": "outline",
+                "type": "line",
+                "source": "geojson",
+                "paint": {"line-color": "#000000", "line-width": 1},
+            },
+        ]
+    )
+    benchmark.pedantic(
+        render_geojson, args=(style, make_polygons(count), 1024, 1024), rounds=3
+    )
+
+
+@pytest.mark.benchmark(group="offline-labels")
+@pytest.mark.parametrize("count", [1000, 10000])
+def test_icon_labels(benchmark, count):
+    # icons are placed with collision detection, like text labels
+    style = geojson_style(
+        [
+            {
+                "id": "icons",
+                "type": "symbol",
+                "source": "geojson",
+                "layout": {"icon-image": "marker", "icon-allow-overlap": False},
+            }
+        ]
+    )
+    geojson = make_points(count)
+
+    def render():
+        with Map(style, 1024, 1024) as map:
+            map.addImage("marker", MARKER, 16, 16, 1, False)
+            map.setGeoJSON("geojson", geojson)
+            map.renderPNG()
+
+    benchmark.pedantic(render, rounds=3)
+
+
+@pytest.mark.skipif(not GLYPHS_URL, reason="PYMGL_BENCH_GLYPHS not set")
+@pytest.mark.benchmark(group="offline-labels")
+@pytest.mark.parametrize("count", [1000, 10000])
+def test_text_labels(benchmark, count):
+    style = geojson_style(
+        [
+            {
+                "id": "labels",
+                "type": "symbol",
+                "source": "geojson",
+                "layout": {"text-field": ["get", "label"], "text-size": 12},
+                "paint": {"text-halo-color": "#FFFFFF", "text-halo-width": 1},
+            }
+        ],
+        glyphs=GLYPHS_URL,
+    )
+    benchmark.pedantic(
+        render_geojson, args=(style, make_points(count), 1024, 1024), rounds=3
+    )
+
+
+@pytest.mark.benchmark(group="offline-threads")
+@pytest.mark.parametrize("threads", [1, 2, 4, 8])
+def test_concurrent_maps(benchmark, threads):
+    style = mbtiles_style("example-style-mbtiles-vector-source.json")
+    benchmark.pedantic(render_concurrent, args=(style, threads, 16), rounds=3)
+
+
+@pytest.mark.benchmark(group="offline-warm")
+@pytest.mark.parametrize(
+    "filename",
+    [
+        "example-style-empty.json",
+        "example-style-geojson.json",
+        "example-style-mbtiles-raster-source.json",
+        "example-style-mbtiles-vector-source.json",
+    ],
+)
+@pytest.mark.parametrize("size", [256, 1024])
+def test_warm_map(benchmark, filename, size):
+    with Map(mbtiles_style(filename), size, size) as map:
+        # load all resources before timing renders
+        map.renderPNG()
+        benchmark(map.renderPNG)
@@ -185,12 +185,14 @@ def test_render_file_geojson_256(benchmark):
     benchmark(render, style, 256, 256, bounds=(-125, 37.5, -115, 42.5))
 
 
+@pytest.mark.network
 @pytest.mark.benchmark(group="render-remote-raster-256")
 def test_render_remote_raster_256(benchmark):
     style = read_style("example-style-remote-raster.json")
     benchmark(render, style, 256, 256)
 
 
+@pytest.mark.network
 @pytest.mark.benchmark(group="render-remote-raster-1024")
 def test_render_remote_raster_1024(benchmark):
     style = read_style("example-style-remote-raster.json")
@@ -221,12 +223,14 @@ def test_render_remote_raster_mbglr_1024(benchmark):
     )
 
 
+@pytest.mark.network
 @pytest.mark.benchmark(group="render-remote-image-source-256")
 def test_render_remote_image_source(benchmark):
     style = read_style("example-style-remote-image-source.json")
     benchmark(render, style, 256, 256)
 
 
+@pytest.mark.network
 @pytest.mark.skipif(SKIP_MAPBOX, reason="Skipping mapbox tests")
 @pytest.mark.benchmark(group="render-mapbox-source-256")
 def test_render_mapbox_256(benchmark):
@@ -234,6 +238,7 @@ def test_render_mapbox_256(benchmark):
     benchmark(render, style, 256, 256, token=MAPBOX_TOKEN, provider="mapbox")
 
 
+@pytest.mark.network
 @pytest.mark.skipif(SKIP_MAPBOX, reason="Skipping mapbox tests")
 @pytest.mark.benchmark(group="render-mapbox-source-1024")
 def test_render_mapbox_1024(benchmark):
@@ -257,6 +262,7 @@ def test_render_mapbox_mbglr_1024(benchmark):
     benchmark(render_mbgl_renderer, style, 1024, 1024, token=MAPBOX_TOKEN)
 
 
+@pytest.mark.network
 @pytest.mark.benchmark(group="render-labels")
 def test_render_labels(benchmark):
     style = read_style("example-style-geojson-labels.json")
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <mbgl/util/image.hpp>
+
+namespace mgl_wrapper {
+
+// Processes rendered frames on a worker thread, in order, so that converting
+// and writing frame N overlaps rendering frame N+1.  Up to depth frames are
+// queued; push() blocks while the queue is full.
+//
+// maplibre-native reads back each frame synchronously before returning it, so
+// readback itself cannot overlap drawing; everything after readback
+// (unpremultiplying, encoding, and output) is moved off the render thread.
+class FramePipeline {
+public:
+    // Called on the worker thread with the index of each frame in the order
+    // pushed
+    using Process = std::function<void(uint64_t index, mbgl::PremultipliedImage image)>;
+
+    FramePipeline(Process process, size_t depth = 2);
+
+    // Stops processing; frames still queued are discarded
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline &) = delete;
+
+    // Queue a frame, rethrowing any error raised while processing an earlier
+    // frame
+    void push(mbgl::PremultipliedImage image);
+
+    // Wait for all queued frames to be processed, rethrowing any error raised
+    // while processing them
+    void finish();
+
+private:
+    void run();
+
+    Process process;
+    const size_t depth;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<uint64_t, mbgl::PremultipliedImage>> queue;
+    uint64_t next = 0;
+    bool done     = false;
+    std::exception_ptr error;
+
+    // started last so that all other members are initialized
+    std::thread worker;
+};
+
+} // namespace mgl_wrapper
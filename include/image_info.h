@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace mgl_wrapper {
+
+using Color = std::array<uint8_t, 4>;
+
+// Return the color of an image of 4 byte pixels if every pixel is the same,
+// otherwise nothing.  Returns at the first block of pixels that differs, so it
+// is fast for most images that are not uniform.
+std::optional<Color> uniformColor(const uint8_t *data, size_t pixels);
+
+// XXH64 hash of data, for deduplicating rendered outputs
+uint64_t xxhash64(const uint8_t *data, size_t size, uint64_t seed = 0);
+
+// Encode a PNG of width x height filled with an unpremultiplied RGBA color.
+// The image is encoded with a single color palette, so it is much smaller and
+// faster to encode than the RGBA image.
+std::string encodeUniformPNG(uint32_t width, uint32_t height, const Color &color);
+
+} // namespace mgl_wrapper
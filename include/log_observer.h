@@ -3,9 +3,12 @@
 #include <iostream>
 #include <ostream>
 
+#include <mbgl/util/enum.hpp>
 #include <mbgl/util/event.hpp>
 #include <mbgl/util/logging.hpp>
 
+#include "trace.h"
+
 namespace mgl_wrapper {
 
 class LogObserver : public mbgl::Log::Observer {
@@ -15,6 +18,14 @@ class LogObserver : public mbgl::Log::Observer {
                   int64_t code,
                   const std::string &msg) {
 
+        if (tracing::isEnabled()) {
+            tracing::instant(mbgl::Enum<mbgl::Event>::toString(event),
+                             "log",
+                             {{"severity", mbgl::Enum<mbgl::EventSeverity>::toString(severity)},
+                              {"code", std::to_string(code)},
+                              {"message", msg}});
+        }
+
         if (event == mbgl::Event::ParseStyle && severity == mbgl::EventSeverity::Warning) {
             std::cerr << "Error parsing style: " << msg << std::endl;
         }
@@ -1,13 +1,29 @@
 #pragma once
 
+#include <functional>
 #include <iomanip>
+#include <map>
+#include <memory>
 #include <optional>
 #include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <mbgl/gfx/headless_frontend.hpp>
+#include <mbgl/gfx/rendering_stats.hpp>
 #include <mbgl/map/map.hpp>
+#include <mbgl/util/image.hpp>
+#include <mbgl/style/source.hpp>
 #include <mbgl/util/run_loop.hpp>
 
+#include "image_info.h"
+#include "render_stats.h"
+#include "resource_accounting.h"
+#include "style.h"
+#include "tile_writer.h"
+#include "trace.h"
+
 namespace mgl_wrapper {
 
 // adapted from mbgl/test/stub_map_observer.hpp to implement only those callbacks
@@ -15,21 +31,98 @@ namespace mgl_wrapper {
 class MapObserver : public mbgl::MapObserver {
 public:
     void onDidFinishLoadingStyle() final {
+        tracing::instant("didFinishLoadingStyle", "map");
         if (didFinishLoadingStyleCallback) {
             didFinishLoadingStyleCallback();
         }
     }
 
     void onDidFailLoadingMap(mbgl::MapLoadError type, const std::string &description) final {
+        tracing::instant("didFailLoadingMap", "map", {{"description", description}});
         if (didFailLoadingMapCallback) {
             didFailLoadingMapCallback(type, description);
         }
     }
 
+    void onSourceChanged(mbgl::style::Source &source) final {
+        tracing::instant("sourceChanged", "map", {{"source", source.getID()}});
+    }
+
     std::function<void()> didFinishLoadingStyleCallback;
     std::function<void(mbgl::MapLoadError, const std::string &)> didFailLoadingMapCallback;
 };
 
+// Encode an unpremultiplied image to PNG bytes
+std::string encodePNG(const mbgl::UnassociatedImage &image);
+
+// A style mutation that can be queued and applied together with others.
+// type is the name of the equivalent Map method (e.g., "setPaintProperty") and
+// args are its arguments encoded as strings, in the same order as that method.
+struct StyleOperation {
+    std::string type;
+    std::vector<std::string> args;
+};
+
+// Memory held by a map, in bytes.  GPU memory is as of the most recent render;
+// glyph and sprite atlases are held as textures.
+struct MemoryUsage {
+    uint64_t textures = 0;
+    // vertex, index, and uniform buffers
+    uint64_t buffers = 0;
+    // images added to the style
+    uint64_t images = 0;
+    // GeoJSON data held by sources, as encoded JSON
+    uint64_t geoJSON = 0;
+
+    // GPU objects held by the renderer, as of the most recent render
+    uint32_t textureCount     = 0;
+    uint32_t bufferCount      = 0;
+    uint32_t framebufferCount = 0;
+};
+
+// Camera position of a frame rendered by Map::renderMany
+struct Camera {
+    double longitude;
+    double latitude;
+    double zoom;
+    double bearing = 0;
+    double pitch   = 0;
+};
+
+// Keyframe of a camera path rendered by Map::renderPath
+struct Keyframe {
+    // seconds from the start of the path
+    double time;
+    Camera camera;
+    // easing of the transition from the previous keyframe: linear, ease,
+    // ease-in, ease-out, or ease-in-out
+    std::string easing = "linear";
+};
+
+// Image rendered by Map::renderWithInfo, with information to deduplicate it
+struct RenderedImage {
+    // PNG bytes or RGBA pixels
+    std::string data;
+    // unpremultiplied color of every pixel if the image is a single color
+    std::optional<Color> uniformColor;
+    // XXH64 hash of data
+    uint64_t hash = 0;
+};
+
+// Tile in the XYZ scheme rendered by Map::renderTiles
+struct TileID {
+    uint32_t z;
+    uint32_t x;
+    uint32_t y;
+};
+
+// Receives the RGBA pixels of each frame rendered by Map::renderPath
+using FrameCallback = std::function<void(const uint8_t *data, size_t size)>;
+
+// Return the camera at time along a path between keyframes, which must be in
+// order of time.  Longitude and bearing change in the shortest direction.
+Camera interpolateCamera(const std::vector<Keyframe> &keyframes, double time);
+
 class Map {
 public:
     Map(const std::string &style,
@@ -42,6 +135,17 @@ public:
         const std::optional<std::string> &token    = {},
         const std::optional<std::string> &provider = {});
 
+    // Construct from a style template, which avoids parsing the style again
+    Map(const std::shared_ptr<StyleTemplate> &style,
+        const std::optional<uint32_t> &width       = {},
+        const std::optional<uint32_t> &height      = {},
+        const std::optional<float> &ratio          = {},
+        const std::optional<double> &longitude     = {},
+        const std::optional<double> &latitude      = {},
+        const std::optional<double> &zoom          = {},
+        const std::optional<std::string> &token    = {},
+        const std::optional<std::string> &provider = {});
+
     // Underlying constructs do not support easy copy, so prevent them here
     Map(const Map &) = delete;
     ~Map();
@@ -50,6 +154,91 @@ public:
     const std::string renderPNG();
     const std::unique_ptr<uint8_t[]> renderBuffer();
 
+    // Render the map to PNG, writing encoded rows to a file or file descriptor
+    // as they are produced rather than encoding the whole image in memory
+    void renderPNGToFile(const std::string &filename);
+    void renderPNGToFile(int fd);
+
+    // Render the map into a named POSIX shared memory segment as unpremultiplied
+    // RGBA pixels following a SharedFrameHeader, so that other processes can
+    // map the frame without copying it.  Returns the sequence number of the
+    // frame.
+    const uint64_t renderToSharedMemory(const std::string &name);
+
+    // Render a frame for each camera, in order.  Each frame is encoded as PNG
+    // if format is "png", or copied as RGBA pixels if "buffer".  Tiles,
+    // glyphs, and sprites loaded for earlier frames are reused by later
+    // frames, and the camera is restored afterwards.
+    const std::vector<std::string> renderMany(const std::vector<Camera> &cameras,
+                                              const std::string &format = "png");
+
+    // Render frames at fps along a camera path interpolated between keyframes
+    // and pass the RGBA pixels of each frame to callback, in order.  Frames
+    // are unpremultiplied and passed to callback on a separate thread while
+    // the next frame is rendered.  The camera is restored afterwards.  Returns
+    // the number of frames rendered.
+    const uint64_t renderPath(const std::vector<Keyframe> &keyframes,
+                              double fps,
+                              const FrameCallback &callback);
+
+    // Render the map as PNG if format is "png", or as RGBA pixels if "buffer",
+    // with a hash of the output and its color if it is a single color.  Images
+    // of a single color skip unpremultiplying and are encoded as a cached
+    // palette PNG, which is much smaller than encoding every pixel.
+    const RenderedImage renderWithInfo(const std::string &format = "png");
+
+    // Render a frame at each pixel ratio, returned in order, as for
+    // setPixelRatio.  Each frame is encoded as PNG if format is "png", or as
+    // RGBA pixels if "buffer".  Frames at the current ratio are rendered
+    // first, and a renderer is created once for each other ratio; the current
+    // renderer, with its tiles, is kept and restored afterwards.
+    const std::vector<std::string> renderAtRatios(const std::vector<float> &ratios,
+                                                  const std::string &format = "png");
+
+    // Render only the window of width x height at x, y (in logical pixels from
+    // the top left) of the map at its current size and camera, by rendering a
+    // viewport of that size centered on the window rather than cropping a full
+    // render.  Returns PNG if format is "png", or RGBA pixels if "buffer".
+    // Labels near the edges of the window may be placed differently than in
+    // a full render.  Pitch must be 0.
+    const std::string renderRegion(uint32_t x,
+                                   uint32_t y,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   const std::string &format = "png");
+
+    // Render an image of width x height (in logical pixels, before the pixel
+    // ratio) centered on the current camera to a PNG file, as a grid of tiles
+    // of tileSize rendered one at a time.  Each tile is rendered with overlap
+    // pixels of surrounding map on each side so that labels near its edges are
+    // placed consistently with neighboring tiles.  Tiles are encoded a row at
+    // a time, so only one row of tiles is held in memory.  Bearing and pitch
+    // must be 0.
+    void renderTiledPNG(const std::string &filename,
+                        uint32_t width,
+                        uint32_t height,
+                        uint32_t tileSize = 1024,
+                        uint32_t overlap  = 128);
+
+    // Render each tile as PNG and add it to writer, such as an MBTilesWriter
+    // or PMTilesWriter.  The map must be square; its width is the size of
+    // each tile in logical pixels, so tiles of zoom z are rendered at zoom
+    // z + log2(width / 512).  Each tile is encoded and written while the next
+    // is rendered, and tiles of a single color share one cached image as for
+    // renderWithInfo.  If skipEmpty, only the first tile of each zoom for
+    // which tileHasData(buffer) is false is rendered; if it is a single
+    // color, such as the background, its image is written for the other such
+    // tiles of that zoom.  The camera is restored afterwards.  Returns the
+    // number of tiles written.
+    const uint64_t renderTiles(const std::vector<TileID> &tiles,
+                               TileWriter &writer,
+                               bool skipEmpty = true,
+                               double buffer  = 0.25);
+
+    // Render frames along a camera path and write their RGBA pixels to a file
+    // descriptor, such as a pipe to a video encoder
+    const uint64_t renderPath(const std::vector<Keyframe> &keyframes, double fps, int fd);
+
     const double getBearing();
     const std::pair<double, double> getCenter();
     const std::optional<std::string> getFeatureState(const std::string &sourceID,
@@ -61,7 +250,23 @@ public:
     const std::optional<std::string> getLayerJSON(const std::string &layerID);
     const bool getVisibility(const std::string &layerID);
     const double getPitch();
+    const float getPixelRatio();
     const std::pair<uint32_t, uint32_t> getSize();
+    const std::vector<std::pair<std::string, SourceStats>> getSourceStats();
+
+    // Return the extent of the data of a source, from the bounds of its
+    // tileset or the coordinates of its GeoJSON data, or nothing if it is not
+    // known or the source has no data.  Tilesets loaded from a URL are only
+    // known once the style has loaded.
+    const std::optional<Bounds> getSourceBounds(const std::string &sourceID);
+
+    // Return false if no source has data within tile z/x/y, expanded by
+    // buffer (a fraction of the width of the tile) to include features drawn
+    // beyond their coordinates, so that the tile can be skipped or filled with
+    // the background without rendering it.  Sources of unknown extent are
+    // assumed to have data everywhere.
+    const bool tileHasData(uint32_t z, uint32_t x, uint32_t y, double buffer = 0.25);
+    const RenderStats getStats();
     const double getZoom();
 
     const std::vector<std::string> listLayers();
@@ -69,6 +274,22 @@ public:
 
     void load();
 
+    const MemoryUsage memoryUsage();
+
+    // Release memory held by the renderer without destroying the map.  Tiles
+    // and GPU resources that are not in use are released; if aggressive, all
+    // tiles are released and reloaded when the map is next rendered.  GPU
+    // resources are freed during the next render, so memoryUsage() reflects
+    // the release only after rendering again.
+    void trim(bool aggressive = false);
+
+    // Return the time in milliseconds that each layer adds to drawing a frame,
+    // in style order, as the median of iterations.  Times are wall-clock
+    // differences from hiding each layer rather than GPU timer queries, and
+    // are not broken down by render pass.  Layers that are not visible take
+    // no time.
+    const std::vector<std::pair<std::string, double>> profileLayers(uint32_t iterations = 3);
+
     void addImage(const std::string &name,
                   const std::string &image,
                   uint32_t width,
@@ -79,6 +300,15 @@ public:
     void addSource(const std::string &id, const std::string &options);
     void addLayer(const std::string &options);
 
+    // Queue style mutations (addSource, addLayer, setFilter, setPaintProperty,
+    // setVisibility) until commitBatch(), which validates all of them before
+    // applying any.
+    void beginBatch();
+    void commitBatch();
+    void discardBatch();
+    const bool isBatching();
+    void applyStyleOperations(const std::vector<StyleOperation> &operations);
+
     void removeFeatureState(const std::string &sourceID,
                             const std::string &layerID,
                             const std::string &featureID,
@@ -105,11 +335,31 @@ public:
     void setZoom(const double &zoom);
     void setSize(const uint32_t &width, const uint32_t &height);
 
+    // Change the pixel ratio of rendered images.  The ratio is fixed when the
+    // renderer and style are created, so both are recreated; the sources,
+    // layers, and images of the current style are moved to the new style
+    // with any changes made to them, but feature state is cleared.  Tiles are
+    // parsed again, and sprites are loaded at the new ratio.
+    void setPixelRatio(const float &ratio);
+    void setStyle(const std::string &style, bool diff = true);
+
     void release();
+    void resetStats();
 
     friend std::ostream &operator<<(std::ostream &os, Map &m);
 
 private:
+    // resources requested by this map, by source
+    std::shared_ptr<ResourceAccounting> accounting;
+
+    // bytes of images added to the style, by name
+    std::unordered_map<std::string, uint64_t> imageBytes;
+
+    float pixelRatio;
+
+    // GPU resources in use as of the most recent render
+    mbgl::gfx::RenderingStats renderingStats;
+
     std::unique_ptr<mbgl::HeadlessFrontend> frontend;
     std::unique_ptr<mbgl::Map> map;
 
@@ -121,7 +371,74 @@ private:
     // on Linux)
     std::unique_ptr<mbgl::util::RunLoop> loop;
 
+    // style operations queued while a batch is in progress
+    std::optional<std::vector<StyleOperation>> pendingOperations;
+
+    // style JSON last applied via setStyle; the map's style keeps the JSON it
+    // was originally loaded with when a style is applied as a diff
+    std::optional<std::string> currentStyleJSON;
+
+    RenderStats stats;
+
+    // phases timed since the last completed render, including style loads
+    RenderPhases currentPhases;
+
+    // time since the start of the current render
+    Timer renderTimer;
+
+    // create the frontend and map without loading a style; each constructor
+    // then loads its style and sets the initial camera
+    void init(const std::optional<uint32_t> &width,
+              const std::optional<uint32_t> &height,
+              const std::optional<float> &ratio,
+              const std::optional<double> &zoom,
+              const std::optional<std::string> &token,
+              const std::optional<std::string> &provider);
+    void jumpToInitialCamera(const std::optional<double> &longitude,
+                             const std::optional<double> &latitude,
+                             const std::optional<double> &zoom);
+
+    bool applyStyleDiff(const std::string &style);
+    void loadStyleJSON(const std::string &style);
+
+    // render a still image and time the load, draw, and readback phases
+    mbgl::PremultipliedImage renderStill();
+    void finishRenderStats(const Timer &timer);
+
+    // add phases of frames processed by a FramePipeline, which overlap
+    // rendering of later frames, to cumulative stats
+    void addPipelinedPhases(const RenderPhases &phases);
+
+    void jumpTo(const Camera &camera);
+
+    // create a frontend and map at ratio with the top-level properties of the
+    // current style, such as its sprite and glyphs, but none of its sources
+    // or layers, and the current camera
+    std::pair<std::unique_ptr<mbgl::HeadlessFrontend>, std::unique_ptr<mbgl::Map>>
+    createRenderer(float ratio);
+
+    // move the sources and layers of the style of from to the style of to, and
+    // copy the images added to it.  If any cannot be added, they are all moved
+    // back to from and the error is rethrown.
+    void moveStyleContents(mbgl::Map &from, mbgl::Map &to);
+
+    // unpremultiply a rendered image and encode it as PNG if format is "png",
+    // or return its RGBA pixels if "buffer", adding the time of both to phases
+    std::string encodeFrame(mbgl::PremultipliedImage premultiplied,
+                            const std::string &format,
+                            RenderPhases &phases);
+
+    // encode a rendered image as for encodeFrame, except that images of a
+    // single color are detected and encoded from uniformPNGs
+    RenderedImage encodeFrameWithInfo(mbgl::PremultipliedImage premultiplied,
+                                      const std::string &format,
+                                      RenderPhases &phases);
+
+    // PNGs of images of a single color, by width, height, and RGBA color
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t>, std::string> uniformPNGs;
+
     void validateBearing(const double &bearing);
+    void validateCenter(const double &longitude, const double &latitude);
     void validateDimension(const uint32_t &value, const std::string dimType);
     void validatePitch(const double &pitch);
     void validatePixelRatio(const float &ratio);
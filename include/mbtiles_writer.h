@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "tile_writer.h"
+
+namespace mapbox {
+namespace sqlite {
+class Database;
+class Statement;
+class Transaction;
+} // namespace sqlite
+} // namespace mapbox
+
+namespace mgl_wrapper {
+
+// Writes raster tiles to an MBTiles file.  Tiles are stored in a map table
+// that references images by hash, so tiles with identical images (such as
+// empty ocean tiles) share a single image; a tiles view joins the two for
+// readers.  Images with the same hash are compared byte for byte before one
+// is reused.  Inserts are committed in transactions of batchSize tiles rather
+// than one at a time.  An existing file written by this class is added to,
+// replacing tiles that are written again.
+class MBTilesWriter : public TileWriter {
+public:
+    MBTilesWriter(const std::string &filename, uint32_t batchSize = 1000);
+
+    // Commits pending tiles; errors are ignored, so call close() to handle
+    // them
+    ~MBTilesWriter();
+
+    MBTilesWriter(const MBTilesWriter &) = delete;
+
+    using TileWriter::addTile;
+
+    // Set a value in the metadata table, such as name, format, or bounds
+    void setMetadata(const std::string &name, const std::string &value) override;
+
+    // Add the image of tile z/x/y; it is stored in the TMS scheme used by
+    // MBTiles
+    void addTile(
+        uint32_t z, uint32_t x, uint32_t y, const std::string &data, uint64_t hash) override;
+
+    // Commit pending tiles
+    void flush() override;
+
+    // Commit pending tiles, delete images that are no longer referenced by
+    // any tile, and close the file
+    void close() override;
+
+    const uint64_t getTileCount() override;
+    const uint64_t getImageCount() override;
+
+private:
+    void begin();
+
+    const uint32_t batchSize;
+    uint32_t pending    = 0;
+    uint64_t tileCount  = 0;
+    uint64_t imageCount = 0;
+
+    std::unique_ptr<mapbox::sqlite::Database> db;
+    std::unique_ptr<mapbox::sqlite::Statement> selectImage;
+    std::unique_ptr<mapbox::sqlite::Statement> insertImage;
+    std::unique_ptr<mapbox::sqlite::Statement> insertTile;
+    std::unique_ptr<mapbox::sqlite::Transaction> transaction;
+};
+
+} // namespace mgl_wrapper
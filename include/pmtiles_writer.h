@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tile_writer.h"
+
+namespace mgl_wrapper {
+
+// Writes tiles to a PMTiles v3 archive.  Tiles may be added in any order; the
+// data of each distinct image is appended to an unlinked temporary file as it
+// is added, after comparing it with the stored images of the same hash, and
+// close() writes the archive in a final pass: tiles are sorted
+// by Hilbert tile ID, tile data is copied in that order so that the archive
+// is clustered, runs of consecutive tiles with the same image are stored as
+// one directory entry, and directories are split into leaf directories if the
+// root directory would not fit in the first 16 KiB of the archive.
+class PMTilesWriter : public TileWriter {
+public:
+    PMTilesWriter(const std::string &filename);
+
+    // Writes the archive; errors are ignored, so call close() to handle them
+    ~PMTilesWriter();
+
+    PMTilesWriter(const PMTilesWriter &) = delete;
+
+    using TileWriter::addTile;
+
+    // Set a value of the JSON metadata of the archive
+    void setMetadata(const std::string &name, const std::string &value) override;
+
+    // Add the image of tile z/x/y; a tile that is added again replaces its
+    // earlier image
+    void addTile(
+        uint32_t z, uint32_t x, uint32_t y, const std::string &data, uint64_t hash) override;
+
+    // Tile data is written as tiles are added, so there is nothing to flush
+    void flush() override;
+
+    // Write the header, directories, metadata, and tile data of the archive
+    void close() override;
+
+    const uint64_t getTileCount() override;
+    const uint64_t getImageCount() override;
+
+private:
+    // location of an image in the temporary file
+    struct Image {
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    struct Tile {
+        uint64_t tileID;
+        // index in images
+        uint32_t image;
+    };
+
+    void writeArchive();
+
+    std::string filename;
+    int fd = -1;
+
+    // temporary file of image data, in the order images were added
+    int dataFd        = -1;
+    uint64_t dataSize = 0;
+
+    std::map<std::string, std::string> metadata;
+    std::vector<Tile> tiles;
+    std::vector<Image> images;
+    // indexes in images of the images with each hash
+    std::unordered_multimap<uint64_t, uint32_t> imagesByHash;
+
+    // PMTiles tile type of the first tile, detected from its data
+    uint8_t tileType = 0;
+
+    // zooms and extent of the tiles added, as fractions of the width of the
+    // world from the northwest corner
+    uint32_t minZoom = 31;
+    uint32_t maxZoom = 0;
+    double minX      = 1;
+    double minY      = 1;
+    double maxX      = 0;
+    double maxY      = 0;
+};
+
+// Return the PMTiles tile ID of tile z/x/y: the number of tiles at lower
+// zooms plus the position of the tile along a Hilbert curve at zoom z
+uint64_t zxyToTileID(uint32_t z, uint32_t x, uint32_t y);
+
+} // namespace mgl_wrapper
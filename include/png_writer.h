@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+
+#include "spng.h"
+
+namespace mgl_wrapper {
+
+// Encodes an unpremultiplied RGBA image to PNG a band of rows at a time, so
+// that the full image never needs to be held in memory.  Encoded bytes are
+// passed to write as they are produced.
+class PNGWriter {
+public:
+    using Write = std::function<void(const uint8_t *data, size_t size)>;
+
+    PNGWriter(uint32_t width, uint32_t height, Write write);
+    ~PNGWriter();
+
+    PNGWriter(const PNGWriter &) = delete;
+
+    // Encode the next rows of the image, in order; data holds rows * width * 4
+    // bytes.  The PNG is complete once all rows are written.
+    void writeRows(const uint8_t *data, uint32_t rows);
+
+    const bool isComplete();
+
+private:
+    static int onWrite(spng_ctx *ctx, void *user, void *data, size_t length);
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowsWritten = 0;
+    Write write;
+    spng_ctx *ctx = nullptr;
+
+    // error raised by write, which must not propagate through spng
+    std::exception_ptr error;
+};
+
+// Write all of data to a file descriptor, retrying partial writes
+void writeAll(int fd, const uint8_t *data, size_t size);
+
+} // namespace mgl_wrapper
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace mgl_wrapper {
+
+// Time spent in each phase of rendering, in milliseconds
+struct RenderPhases {
+    // parsing and loading the style
+    double styleLoad = 0;
+    // fetching resources, parsing tiles, and layout, until the frame is drawn
+    double load = 0;
+    // drawing the frame that is read back; this is timed on the main thread and
+    // may include other events handled while the frame is drawn
+    double draw = 0;
+    // reading pixels back from the GPU
+    double readback      = 0;
+    double unpremultiply = 0;
+    double encode        = 0;
+    // includes any style loads since the previous render
+    double total = 0;
+
+    RenderPhases &operator+=(const RenderPhases &other) {
+        styleLoad += other.styleLoad;
+        load += other.load;
+        draw += other.draw;
+        readback += other.readback;
+        unpremultiply += other.unpremultiply;
+        encode += other.encode;
+        total += other.total;
+        return *this;
+    }
+};
+
+struct RenderStats {
+    uint64_t frames = 0;
+
+    // phases of the most recent render
+    RenderPhases last;
+
+    // phases of all renders since the map was created or stats were reset
+    RenderPhases cumulative;
+};
+
+// Monotonic timer
+class Timer {
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    // milliseconds since the timer was created or reset
+    double elapsed() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    }
+
+    void reset() { start = std::chrono::steady_clock::now(); }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace mgl_wrapper
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include "source_coverage.h"
+
+namespace mgl_wrapper {
+
+// Resources loaded for a source since the map was created
+struct SourceStats {
+    // responses received, including tilesets and GeoJSON data
+    uint64_t requests = 0;
+    // distinct tiles requested
+    uint64_t tiles  = 0;
+    uint64_t bytes  = 0;
+    uint64_t errors = 0;
+    // responses confirming that a cached resource is still valid
+    uint64_t notModified = 0;
+    // total time from request to response, in milliseconds
+    double loadTime = 0;
+};
+
+// Counts the resources requested by a map so that they can be attributed to
+// the sources in its style.  Tiles are counted by URL template and other
+// resources by URL; tilesets referenced by URL are read from their responses.
+// The extent of the data of each source is recorded from the same styles and
+// responses.
+class ResourceAccounting {
+public:
+    // Register a file source with maplibre-native that records responses to
+    // the accounting in scope when each request was made.  Must be called
+    // before creating any maps.
+    static void install();
+
+    // Attribute requests made on the current thread to accounting while in
+    // scope; maplibre-native makes all requests for a map from the thread
+    // that renders it.
+    class Scope {
+    public:
+        Scope(const std::shared_ptr<ResourceAccounting> &accounting);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+    private:
+        std::shared_ptr<ResourceAccounting> previous;
+    };
+
+    static std::shared_ptr<ResourceAccounting> current();
+
+    // Register the sources of a style JSON, replacing any previous sources
+    // with the same IDs
+    void addStyle(const std::string &style);
+    void addSource(const std::string &id, const std::string &options);
+
+    // Record GeoJSON data set directly on a source, parsed from bytes of JSON
+    void setGeoJSON(const std::string &id, const mapbox::geojson::geojson &geoJSON, size_t bytes);
+
+    void record(const mbgl::Resource &resource, const mbgl::Response &response, double loadTime);
+
+    const std::vector<std::pair<std::string, SourceStats>> getSourceStats(
+        const std::vector<std::string> &sourceIDs);
+
+    // Return bytes of GeoJSON data held by the sources, as encoded JSON
+    const uint64_t getGeoJSONBytes(const std::vector<std::string> &sourceIDs);
+
+    SourceCoverage &getCoverage();
+
+private:
+    // true if url is the TileJSON URL of a source, rather than data
+    bool isTileset(const std::string &url);
+
+    struct Counters {
+        SourceStats stats;
+        std::unordered_set<uint64_t> tiles;
+        // bytes of the most recent response
+        uint64_t lastBytes = 0;
+    };
+
+    // GeoJSON data of a source, either inline or loaded from a URL
+    struct GeoJSONData {
+        std::string url;
+        uint64_t bytes = 0;
+    };
+
+    std::mutex mutex;
+
+    // by tile URL template or resource URL
+    std::unordered_map<std::string, Counters> resources;
+
+    // tile URL templates of tilesets loaded from a URL
+    std::unordered_set<std::string> tilesetURLs;
+    std::unordered_map<std::string, std::vector<std::string>> tilesets;
+
+    // tile URL templates and URLs referenced by each source
+    std::unordered_map<std::string, std::vector<std::string>> sources;
+
+    std::unordered_map<std::string, GeoJSONData> geoJSON;
+
+    SourceCoverage coverage;
+};
+
+} // namespace mgl_wrapper
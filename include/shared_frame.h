@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <mbgl/util/image.hpp>
+
+namespace mgl_wrapper {
+
+// Header at the start of a shared memory segment written by writeSharedFrame,
+// followed by pixels at dataOffset.  All fields are native endian.
+//
+// sequence is odd while a frame is being written and even once it is
+// complete.  The writer stores the odd value, places a release fence, writes
+// the header and pixels, and stores the even value with release ordering.
+// Readers in C or C++ must load the sequence with acquire ordering, copy the
+// header and pixels, place an acquire fence, and load the sequence again,
+// retrying if it was odd or changed.
+struct SharedFrameHeader {
+    // "MGLF"
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    // bytes per row
+    uint32_t stride;
+    // 0: unpremultiplied RGBA, 8 bits per channel
+    uint32_t format;
+    uint64_t dataOffset;
+    uint64_t sequence;
+    float pixelRatio;
+    uint8_t reserved[20];
+};
+
+static_assert(sizeof(SharedFrameHeader) == 64, "SharedFrameHeader must be 64 bytes");
+
+// Write image into the named POSIX shared memory segment (shm_open), creating
+// it if needed.  A segment of a different size is unlinked and replaced, so
+// readers must map it again when width or height change.  Returns the
+// sequence number of the frame.
+const uint64_t writeSharedFrame(const std::string &name,
+                                const mbgl::UnassociatedImage &image,
+                                float pixelRatio);
+
+} // namespace mgl_wrapper
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <mbgl/util/geojson.hpp>
+
+namespace mgl_wrapper {
+
+// Extent of the data of a source, in degrees
+struct Bounds {
+    double west;
+    double south;
+    double east;
+    double north;
+};
+
+// Records the extent of the data of each source in a style, so that tiles
+// outside of all sources can be skipped without rendering them.  Extents are
+// read from the bounds of tilesets, including tilesets loaded from a URL such
+// as mbtiles metadata, from the coordinates of GeoJSON data, and from the
+// coordinates of image sources.  Sources without a known extent are assumed
+// to cover the world.
+class SourceCoverage {
+public:
+    // Register a source from its style JSON, replacing any previous source
+    // with the same ID
+    void addSource(const std::string &id, const std::string &options);
+
+    // Record GeoJSON data set directly on a source, as already parsed for the
+    // source so that it is not parsed again
+    void setGeoJSON(const std::string &id, const mapbox::geojson::geojson &geoJSON);
+
+    // Record a tileset or GeoJSON data loaded from url for the sources that
+    // reference it
+    void addResponse(const std::string &url, const std::string &data);
+
+    // Return the extent of the data of a source, or nothing if it is not known
+    // or the source has no data
+    const std::optional<Bounds> getBounds(const std::string &id);
+
+    // Return true if any of the sources may have data within the tile z/x/y,
+    // expanded by buffer, a fraction of the width of the tile, to include
+    // features drawn beyond their coordinates such as labels and lines
+    const bool tileHasData(const std::vector<std::string> &sourceIDs,
+                           uint32_t z,
+                           uint32_t x,
+                           uint32_t y,
+                           double buffer);
+
+private:
+    struct Coverage {
+        // URL of a tileset or GeoJSON data that provides the extent
+        std::string url;
+        // false until the extent is known; bounds is then nothing if the
+        // source has no data
+        bool known = false;
+        std::optional<Bounds> bounds;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Coverage> sources;
+};
+
+// Return the extent of the coordinates of a GeoJSON object, or nothing if it
+// has no coordinates
+std::optional<Bounds> geoJSONBounds(const mapbox::geojson::geojson &geoJSON);
+
+// Return the extent of tile z/x/y expanded by buffer, a fraction of the width
+// of the tile
+Bounds tileBounds(uint32_t z, uint32_t x, uint32_t y, double buffer = 0);
+
+} // namespace mgl_wrapper
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mbgl/style/layer.hpp>
+#include <mbgl/style/style.hpp>
+
+namespace mgl_wrapper {
+
+// An error found while validating a style.  type is one of "style", "source",
+// or "layer"; id is the source or layer ID, if known.
+struct StyleError {
+    std::string type;
+    std::string id;
+    std::string message;
+};
+
+// Validate a style JSON without creating a map or rendering backend; returns
+// an empty vector if the style is valid.
+const std::vector<StyleError> validateStyle(const std::string &style);
+
+// A style that is parsed and validated once and can then be used to construct
+// many maps.  Layers are shared between maps until a map modifies them.
+class StyleTemplate {
+public:
+    StyleTemplate(const std::string &style);
+
+    // Underlying layers are shared with maps, so prevent copies here
+    StyleTemplate(const StyleTemplate &) = delete;
+
+    // Return a template for the style, reusing a cached template if one was
+    // already created for identical style JSON
+    static std::shared_ptr<StyleTemplate> get(const std::string &style);
+    static void clearCache();
+    static const size_t cacheSize();
+
+    const std::string &getJSON() const;
+    const std::vector<std::string> listLayers() const;
+    const std::vector<std::string> listSources() const;
+
+    // Load this template into a map's style
+    void instantiate(mbgl::style::Style &style) const;
+
+private:
+    std::string json;
+
+    // style JSON without any sources or layers
+    std::string skeleton;
+
+    // source ID and JSON-encoded source options, in order of the style
+    std::vector<std::pair<std::string, std::string>> sources;
+
+    std::vector<std::unique_ptr<mbgl::style::Layer>> layers;
+};
+
+} // namespace mgl_wrapper
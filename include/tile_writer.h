@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace mgl_wrapper {
+
+// Destination of tiles rendered by Map::renderTiles, such as an MBTiles or
+// PMTiles file.  Tiles with identical images are stored once.
+class TileWriter {
+public:
+    virtual ~TileWriter() = default;
+
+    // Set a metadata value, such as name, format, or attribution
+    virtual void setMetadata(const std::string &name, const std::string &value) = 0;
+
+    // Add the image of tile z/x/y, in the XYZ scheme.  Identical images are
+    // found by hash, such as the XXH64 hash of data from
+    // Map::renderWithInfo, and compared before they are shared, so a wrong
+    // hash only prevents sharing.
+    virtual void
+    addTile(uint32_t z, uint32_t x, uint32_t y, const std::string &data, uint64_t hash) = 0;
+
+    // Add the image of tile z/x/y, hashing data to identify it
+    void addTile(uint32_t z, uint32_t x, uint32_t y, const std::string &data);
+
+    // Write tiles that are pending
+    virtual void flush() = 0;
+
+    // Finish writing the file.  No tiles can be added afterwards.
+    virtual void close() = 0;
+
+    // Number of tiles added, and of distinct images stored for them
+    virtual const uint64_t getTileCount()  = 0;
+    virtual const uint64_t getImageCount() = 0;
+};
+
+} // namespace mgl_wrapper
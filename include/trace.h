@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mgl_wrapper {
+
+using TraceArgs = std::vector<std::pair<std::string, std::string>>;
+
+// An event in Chrome trace format.  phase is 'X' for a complete event (a span
+// with a duration) or 'i' for an instant event.  Times are in microseconds
+// since this library was loaded, as returned by tracing::now().
+struct TraceEvent {
+    std::string name;
+    std::string category;
+    char phase;
+    double timestamp;
+    double duration;
+    uint32_t thread;
+    TraceArgs args;
+};
+
+// Process-wide recorder of trace events.  Events are kept in a ring buffer, so
+// only the most recent events are retained once it is full.  Recording is a
+// no-op unless tracing was started.
+namespace tracing {
+
+// Start recording into an empty buffer that holds up to capacity events
+void start(size_t capacity = 100000);
+
+// Stop recording; recorded events are kept until tracing is started again
+void stop();
+
+bool isEnabled();
+
+// Microseconds since this library was loaded; events from all threads are
+// timestamped relative to the same epoch
+double now();
+
+void complete(const std::string &name,
+              const std::string &category,
+              double timestamp,
+              double duration,
+              TraceArgs args = {});
+void instant(const std::string &name, const std::string &category, TraceArgs args = {});
+
+// Return recorded events, oldest first
+std::vector<TraceEvent> getEvents();
+
+// Return recorded events as Chrome trace JSON, which can be loaded into
+// Perfetto or chrome://tracing
+std::string toJSON();
+
+} // namespace tracing
+
+// Records a complete event for its lifetime on the current thread
+class TraceSpan {
+public:
+    TraceSpan(const std::string &name, const std::string &category, TraceArgs args = {});
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+
+private:
+    bool enabled;
+    std::string name;
+    std::string category;
+    TraceArgs args;
+    double start;
+};
+
+} // namespace mgl_wrapper
@@ -1,6 +1,26 @@
-from pymgl._pymgl import Map
+from pymgl._pymgl import (
+    Map,
+    MBTilesWriter,
+    PMTilesWriter,
+    StyleTemplate,
+    TileWriter,
+    getTraceJSON,
+    startTracing,
+    stopTracing,
+    validateStyle,
+)
 
-__all__ = ["Map"]
+__all__ = [
+    "Map",
+    "MBTilesWriter",
+    "PMTilesWriter",
+    "StyleTemplate",
+    "TileWriter",
+    "getTraceJSON",
+    "startTracing",
+    "stopTracing",
+    "validateStyle",
+]
 
 from . import _version
 
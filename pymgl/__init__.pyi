@@ -1,9 +1,177 @@
+import os
+from typing import Callable
+
 import numpy as np
 
+def validateStyle(style: str) -> list[dict]:
+    """Validate a style without creating a map.
+
+    Sources, layers, filters, and expressions are validated using the
+    same conversions as loading a style into a map.  Remote resources
+    are not fetched.
+
+    Parameters
+    ----------
+    style : str
+        Mapbox GL / Maplibre GL style object as json-encoded string.
+
+    Returns
+    -------
+    list of dict
+        One entry per error with keys "type" ("style", "source", or
+        "layer"), "id" (source or layer ID, or None), and "message".
+        Empty if the style is valid.
+    """
+
+def startTracing(capacity: int = 100000) -> None:
+    """Start recording trace events for all maps.
+
+    Spans are recorded for map construction, style loads, and each
+    phase of rendering, with instant events for map and log events.
+    Only the most recent events are kept once capacity is reached.
+    Any previously recorded events are discarded.
+
+    Parameters
+    ----------
+    capacity : int, optional (default: 100000)
+        maximum number of events to keep
+    """
+
+def stopTracing() -> None:
+    """Stop recording trace events; recorded events are kept until
+    tracing is started again.
+    """
+
+def getTraceJSON() -> str:
+    """Return recorded trace events as Chrome trace JSON.
+
+    The JSON can be loaded into Perfetto (https://ui.perfetto.dev) or
+    chrome://tracing.
+
+    Returns
+    -------
+    str
+    """
+
+class StyleBatch:
+    def __enter__(self) -> StyleBatch: ...
+    def __exit__(self, exc_type: object, exc_value: str, traceback: str): ...
+
+class StyleTemplate:
+    def __init__(self, style: str) -> StyleTemplate:
+        """Parse and validate a style once so that it can be used to create
+        many maps without parsing it again.
+
+        Layers are shared between maps until a map modifies them.
+
+        Parameters
+        ----------
+        style : str
+            Mapbox GL / Maplibre GL style object as json-encoded string.
+        """
+    @staticmethod
+    def get(style: str) -> StyleTemplate:
+        """Return a template for the style, reusing a cached template if
+        one was already created for identical style JSON.
+
+        Parameters
+        ----------
+        style : str
+            Mapbox GL / Maplibre GL style object as json-encoded string.
+
+        Returns
+        -------
+        StyleTemplate
+        """
+    @staticmethod
+    def clearCache() -> None:
+        """Remove all cached style templates."""
+    @staticmethod
+    def cacheSize() -> int:
+        """Number of cached style templates."""
+    def listLayers(self) -> list:
+        """List layer ids in the template"""
+    def listSources(self) -> list:
+        """List source ids in the template"""
+
+class TileWriter:
+    def __enter__(self) -> TileWriter: ...
+    def __exit__(self, exc_type: object, exc_value: str, traceback: str): ...
+    def setMetadata(self, name: str, value: str) -> None:
+        """Set a metadata value, such as name, format, or attribution.
+
+        Parameters
+        ----------
+        name : str
+        value : str
+        """
+    def addTile(
+        self, z: int, x: int, y: int, data: bytes, hash: int | None = None
+    ) -> None:
+        """Add the image of a tile.
+
+        Parameters
+        ----------
+        z : int
+        x : int
+        y : int
+            tile in the XYZ scheme.
+        data : bytes
+            encoded image of the tile.
+        hash : int, optional (default: None)
+            hash of data used to find identical images, such as the hash
+            returned by Map.renderWithInfo(); data is hashed if None.
+            Images with the same hash are compared before they are shared.
+        """
+    def flush(self) -> None:
+        """Write pending tiles."""
+    def close(self) -> None:
+        """Finish writing the file."""
+    @property
+    def tileCount(self) -> int:
+        """Number of tiles added."""
+    @property
+    def imageCount(self) -> int:
+        """Number of distinct images stored for the tiles added."""
+
+class MBTilesWriter(TileWriter):
+    def __init__(self, filename: str, batchSize: int = 1000) -> MBTilesWriter:
+        """Write raster tiles to an MBTiles file.
+
+        Tiles are stored in the TMS scheme used by MBTiles.  Tiles with
+        identical images share a single stored image, and tiles are
+        committed in transactions of batchSize tiles.  An existing file
+        written by MBTilesWriter is added to, replacing tiles that are
+        written again.  Use as a context manager, or call close() when
+        done; close() also deletes images no longer used by any tile.
+
+        Parameters
+        ----------
+        filename : str
+            path of the MBTiles file to create or add to.
+        batchSize : int, optional (default: 1000)
+            number of tiles to commit in each transaction.
+        """
+
+class PMTilesWriter(TileWriter):
+    def __init__(self, filename: str) -> PMTilesWriter:
+        """Write tiles to a PMTiles v3 archive.
+
+        Tiles may be added in any order.  Tiles with identical images share
+        a single stored image, and the archive is written when closed, with
+        tiles clustered in Hilbert order.  An existing file is replaced.
+        Use as a context manager, or call close() when done.
+
+        Parameters
+        ----------
+        filename : str
+            path of the PMTiles file to create.
+        """
+
 class Map:
     def __init__(
         self,
-        style: str,
+        style: str | StyleTemplate,
         width: int = 256,
         height: int = 256,
         ratio: float = 1,
@@ -17,8 +185,9 @@ class Map:
 
         Parameters
         ----------
-        style : str
-            Mapbox GL / Maplibre GL style object as json-encoded string.
+        style : str or StyleTemplate
+            Mapbox GL / Maplibre GL style object as json-encoded string, or
+            a style template.
         width : int, optional (default: 256)
             Width of output map.
         height : int, optional (default: 256)
@@ -86,6 +255,27 @@ class Map:
         options : str
             JSON-encoded layer options.  Fields are specific to the layer type.
         """
+    def applyStyleOperations(self, operations: list[tuple]) -> None:
+        """Validate and apply a list of style operations in a single call.
+
+        No operations are applied if any of them are invalid.
+
+        Parameters
+        ----------
+        operations : list of tuples
+            Each tuple is the name of a style method followed by its
+            arguments, e.g., ("setPaintProperty", "box", "fill-opacity", "0.5").
+            Supported methods are addSource, addLayer, setFilter,
+            setPaintProperty, and setVisibility.
+        """
+    def batch(self) -> StyleBatch:
+        """Return a context manager that queues style mutations made within
+        it and validates and applies them together on exit.
+
+        Getters return the style as it was before the batch until the
+        batch is applied.  No mutations are applied if any are invalid
+        or if an exception is raised within the context.
+        """
     @property
     def bearing(self) -> float:
         """map bearing, in degrees"""
@@ -96,11 +286,26 @@ class Map:
     def pitch(self) -> float:
         """map pitch, in degrees"""
     @property
+    def pixelRatio(self) -> float:
+        """pixel ratio of rendered images"""
+    @property
     def size(self) -> tuple[float, float]:
         """map size (width, height)"""
     @property
     def zoom(self) -> float:
         """map zoom"""
+    @property
+    def stats(self) -> dict:
+        """Time spent in each phase of rendering, in milliseconds.
+
+        Returns a dict with the number of frames rendered, and the
+        phases of the last render and cumulative phases of all renders.
+        Phases are styleLoad, load (fetching resources, parsing
+        tiles, and layout), draw, readback, unpremultiply, encode, and
+        total.
+        """
+    def resetStats(self) -> None:
+        """Reset render stats."""
     def getFeatureState(self, sourceID: str, layerID: str, featureID: str) -> str:
         """Get the current feature state of a feature
 
@@ -182,8 +387,103 @@ class Map:
         -------
         list
         """
+    def getSourceStats(self) -> dict[str, dict]:
+        """Return resources loaded for each source since the map was created.
+
+        Responses are attributed to a source by its tile URLs, tileset
+        URL, or GeoJSON data URL.
+
+        Returns
+        -------
+        dict
+            source ID to dict of requests (responses received, including
+            tilesets and data), tiles (distinct tiles requested), bytes,
+            errors, notModified (responses confirming that a cached
+            resource is still valid), and loadTime (total time from
+            request to response, in milliseconds).
+        """
+    def getSourceBounds(self, sourceID: str) -> tuple[float, float, float, float] | None:
+        """Return the extent of the data of a source.
+
+        The extent is read from the bounds of a tileset, including
+        tilesets loaded from a URL such as mbtiles metadata, or from the
+        coordinates of GeoJSON data or an image source.  Tilesets loaded
+        from a URL are only known once the style has loaded; call load()
+        first.
+
+        Parameters
+        ----------
+        sourceID : str
+            ID of source
+
+        Returns
+        -------
+        tuple or None
+            (west, south, east, north) in degrees, or None if the extent
+            is not known or the source has no data.
+        """
+    def tileHasData(self, z: int, x: int, y: int, buffer: float = 0.25) -> bool:
+        """Return False if no source has data within a tile.
+
+        Use this to skip rendering tiles outside of the data of sparse
+        sources when rendering a tile pyramid, or to fill them with the
+        background instead.  This only uses the extent of each source
+        (see getSourceBounds()), so it may return True for tiles within
+        the extent that are empty.  Sources of unknown extent are
+        assumed to have data everywhere.
+
+        Parameters
+        ----------
+        z : int
+        x : int
+        y : int
+            tile coordinates
+        buffer : float, optional (default: 0.25)
+            fraction of the width of the tile to expand it by on each
+            side, to include features drawn beyond their coordinates,
+            such as labels and wide lines.
+
+        Returns
+        -------
+        bool
+        """
     def load(self) -> None:
         """Force map to load all assets."""
+    def memoryUsage(self) -> dict[str, int]:
+        """Return memory held by the map, in bytes.
+
+        GPU memory is as of the most recent render.  Glyph and sprite
+        atlases are held as textures.
+
+        Returns
+        -------
+        dict
+            textures, buffers (vertex, index, and uniform buffers),
+            images (images added to the style), geoJSON (GeoJSON data
+            held by sources, as encoded JSON), and total.
+        """
+    def profileLayers(self, iterations: int = 3) -> dict[str, float]:
+        """Measure the time each layer adds to drawing the map.
+
+        The map is rendered with all layers and then with each visible
+        layer hidden in turn; the difference in wall-clock time to
+        render the frame, which includes waiting for the GPU, is
+        attributed to that layer.  Times are not measured with GPU timer
+        queries and are not broken down by render pass, so they are
+        approximate and do not add up to the total time to draw the map.
+
+        Parameters
+        ----------
+        iterations : int, optional (default: 3)
+            number of frames to render for each layer; the median time
+            is used.
+
+        Returns
+        -------
+        dict
+            layer ID to time in milliseconds, in style order.  Layers
+            that are not visible take no time.
+        """
     def removeFeatureState(
         self, sourceID: str, layerID: str, featureID: str, stateKey: str
     ) -> None:
@@ -207,8 +507,268 @@ class Map:
         """Force the map to render in order to load assets and update state."""
     def renderPNG(self) -> bytes:
         """Render the map to PNG bytes."""
+    def renderPNGToFile(self, output: str | os.PathLike | int) -> None:
+        """Render the map to PNG, writing it to a file or file descriptor.
+
+        Rows of the image are encoded and written as they are produced
+        instead of first encoding the whole image in memory, and the GIL
+        is released while rendering and writing.
+
+        Parameters
+        ----------
+        output : str, os.PathLike, or int
+            path of the file to write, or a file descriptor such as a
+            socket or pipe.  A file descriptor is not closed.
+        """
+    def renderToSharedMemory(self, name: str) -> int:
+        """Render the map into a named shared memory segment, so that other
+        processes can read the frame without copying or encoding it.
+
+        The segment is created if needed.  If the size of the map changed
+        since the previous frame, the segment is unlinked and replaced,
+        so readers must open it again.  The segment is not removed when
+        the map is deleted; the reader should unlink it once done.
+
+        The segment starts with a 64 byte header of native endian fields:
+        magic ``b"MGLF"`` (0), version, width, height, stride, and format
+        as uint32 (4-20), pixel data offset as uint64 (24), sequence as
+        uint64 (32), and pixel ratio as float32 (40).  Pixels are
+        unpremultiplied RGBA.
+
+        The sequence is odd while a frame is being written; readers should
+        check that it is even and unchanged after copying pixels.
+
+        Parameters
+        ----------
+        name : str
+            name of the segment, as used by
+            ``multiprocessing.shared_memory.SharedMemory``
+
+        Returns
+        -------
+        int
+            sequence number of the frame
+
+        Examples
+        --------
+        >>> map.renderToSharedMemory("pymgl-frame")
+        >>> shm = SharedMemory(name="pymgl-frame")
+        >>> width, height = np.frombuffer(shm.buf, np.uint32, 2, 8)
+        >>> img = np.frombuffer(shm.buf, np.uint8, width * height * 4, 64)
+        """
     def renderBuffer(self) -> np.ndarray[np.uint8]:
         """Render the map to a numpy array of uint8 pixel values."""
+    def renderMany(
+        self,
+        cameras: list[tuple[float, ...]],
+        format: str = "png",
+    ) -> list[bytes] | list[np.ndarray[np.uint8]]:
+        """Render a frame for each camera in a single call.
+
+        Tiles, glyphs, and sprites loaded for earlier frames are reused
+        by later frames, and the GIL is released while rendering all
+        frames.  The camera of the map is restored afterwards.
+
+        Parameters
+        ----------
+        cameras : list of tuples
+            Each tuple is (longitude, latitude, zoom) with optional
+            bearing and pitch, e.g., (-120, 40, 5, 0, 45).
+        format : str, optional (default: "png")
+            "png" to return PNG bytes, or "buffer" to return numpy
+            arrays of uint8 pixel values as for renderBuffer().
+
+        Returns
+        -------
+        list
+            one frame for each camera, in order.
+        """
+    def renderWithInfo(self, format: str = "png") -> dict:
+        """Render the map with information to deduplicate the output.
+
+        Images of a single color, such as empty ocean or land tiles, are
+        detected without unpremultiplying or encoding every pixel; as
+        PNG they are encoded with a single color palette, which is much
+        smaller, and cached for later images of the same size and color.
+
+        Parameters
+        ----------
+        format : str, optional (default: "png")
+            "png" to return PNG bytes, or "buffer" to return a numpy
+            array of uint8 pixel values as for renderBuffer().
+
+        Returns
+        -------
+        dict
+            "data": PNG bytes or numpy array, "uniform": True if every
+            pixel is the same color, "color": (r, g, b, a) of that color
+            or None, and "hash": XXH64 hash of the PNG bytes or pixels as
+            an int.
+        """
+    def renderAtRatios(
+        self,
+        ratios: list[float],
+        format: str = "png",
+    ) -> list[bytes] | list[np.ndarray[np.uint8]]:
+        """Render a frame of the current camera at each pixel ratio, in
+        order, e.g., to render @1x, @2x, and @3x images from one map.
+
+        The map is changed to each other ratio as for setPixelRatio(), and
+        the pixel ratio of the map is restored afterwards.  Frames at the
+        current ratio are rendered without recreating the renderer, which
+        is kept and restored with its tiles.
+
+        Parameters
+        ----------
+        ratios : list of float
+            pixel ratios greater than 0 and no greater than 8
+        format : str, optional (default: "png")
+            "png" to return PNG bytes, or "buffer" to return numpy
+            arrays of uint8 pixel values as for renderBuffer().
+
+        Returns
+        -------
+        list
+            one frame for each ratio, in order.
+        """
+    def renderRegion(
+        self,
+        x: int,
+        y: int,
+        width: int,
+        height: int,
+        format: str = "png",
+    ) -> bytes | np.ndarray[np.uint8]:
+        """Render only a window of the map at its current size and camera.
+
+        The map is rendered at the size of the window, centered on it,
+        instead of rendering the whole map and cropping, so that only
+        the pixels of the window are drawn and read back.  Labels near
+        the edges of the window may be placed differently than in a
+        full render.  Pitch must be 0.
+
+        Parameters
+        ----------
+        x : int
+            left edge of the window, in pixels from the left of the map
+        y : int
+            top edge of the window, in pixels from the top of the map
+        width : int
+            width of the window
+        height : int
+            height of the window
+        format : str, optional (default: "png")
+            "png" to return PNG bytes, or "buffer" to return a numpy
+            array of uint8 pixel values as for renderBuffer().
+
+        Returns
+        -------
+        bytes or numpy array
+        """
+    def renderTiledPNG(
+        self,
+        filename: str,
+        width: int,
+        height: int,
+        tileSize: int = 1024,
+        overlap: int = 128,
+    ) -> None:
+        """Render an image larger than the map, centered on the current
+        camera, to a PNG file.
+
+        The image is rendered as a grid of tiles one at a time, so it
+        may be larger than the maximum texture size of the GPU.  Rows of
+        tiles are encoded as they are rendered, so only one row of tiles
+        is held in memory.  Bearing and pitch must be 0.
+
+        Parameters
+        ----------
+        filename : str
+            path of the PNG file to write.
+        width : int
+            width of the image in pixels, before the pixel ratio of the
+            map is applied.
+        height : int
+            height of the image in pixels, before the pixel ratio of the
+            map is applied.
+        tileSize : int, optional (default: 1024)
+            width and height of each tile in pixels, before the pixel
+            ratio of the map is applied.
+        overlap : int, optional (default: 128)
+            pixels of surrounding map rendered on each side of each tile
+            and then discarded, so that labels near the edges of tiles are
+            placed consistently with neighboring tiles.
+        """
+    def renderTiles(
+        self,
+        tiles: list[tuple[int, int, int]],
+        writer: TileWriter,
+        skipEmpty: bool = True,
+        buffer: float = 0.25,
+    ) -> int:
+        """Render tiles as PNG and add them to an MBTiles or PMTiles file.
+
+        The map must be square; its width is the size of each tile, so
+        a 256 x 256 map renders tiles of zoom z at zoom z - 1.  Each tile
+        is encoded and written while the next is rendered, and tiles of
+        a single color share one stored image.  The camera of the map is
+        restored afterwards.
+
+        Parameters
+        ----------
+        tiles : list of tuples
+            (z, x, y) of each tile in the XYZ scheme.
+        writer : MBTilesWriter or PMTilesWriter
+            writer to add tiles to; pending tiles are flushed when done.
+        skipEmpty : bool, optional (default: True)
+            if True, only the first tile of each zoom for which
+            tileHasData() is False is rendered; if it is a single color,
+            such as the background, its image is written for the other
+            such tiles of that zoom.
+        buffer : float, optional (default: 0.25)
+            buffer passed to tileHasData().
+
+        Returns
+        -------
+        int
+            number of tiles written.
+        """
+    def renderPath(
+        self,
+        keyframes: list[tuple[float | str, ...]],
+        fps: float,
+        output: int | Callable[[bytes], None],
+    ) -> int:
+        """Render frames along a camera path interpolated between keyframes.
+
+        Frames are rendered at fps from the time of the first keyframe
+        to the time of the last, including both.  Each frame is written
+        as RGBA pixels (width * height * 4 bytes) to output while the
+        next frame is rendered.  The camera of the map is restored
+        afterwards.
+
+        Parameters
+        ----------
+        keyframes : list of tuples
+            Each tuple is (time, longitude, latitude, zoom) with optional
+            bearing and pitch, followed by an optional easing of the
+            transition from the previous keyframe: "linear" (default),
+            "ease", "ease-in", "ease-out", or "ease-in-out".  Time is in
+            seconds and keyframes must be in order of time.  Longitude and
+            bearing change in the shortest direction, so a path may cross
+            the antimeridian.
+        fps : float
+            frames per second.
+        output : int or callable
+            file descriptor to write frames to, e.g., the stdin of a
+            video encoder subprocess, or a function called with the
+            bytes of each frame, in order.
+
+        Returns
+        -------
+        int
+            number of frames rendered.
+        """
     def setBearing(self, bearing: float) -> None:
         """Set the bearing of the map.
 
@@ -280,6 +840,22 @@ class Map:
         value : JSON str
             JSON-encoded value of paint property
         """
+    def setStyle(self, style: str, diff: bool = True) -> None:
+        """Set the style of the map.
+
+        By default, only the sources and layers that differ from the
+        current style are replaced, which keeps loaded tiles for
+        unchanged sources.  The whole style is reloaded if other
+        top-level properties (e.g., sprite or glyphs) differ or if the
+        order of unchanged layers differs.
+
+        Parameters
+        ----------
+        style : str
+            Mapbox GL / Maplibre GL style object as json-encoded string.
+        diff : bool, optional (default: True)
+            If False, always reload the whole style.
+        """
     def setVisibility(self, layerID: str, visible: bool) -> None:
         """Set the visibility of a layer in the map
 
@@ -314,3 +890,30 @@ class Map:
         width : int
         height : int
         """
+    def setPixelRatio(self, ratio: float) -> None:
+        """Set the pixel ratio of rendered images.
+
+        The renderer and style are recreated at the new ratio.  Sources,
+        layers, and images added to the map are kept, including changes
+        made to them, but feature state is cleared.  Tiles are parsed
+        again and sprites are loaded at the new ratio the next time the
+        map is rendered.
+
+        Parameters
+        ----------
+        ratio : float
+            pixel ratio greater than 0
+        """
+    def trim(self, aggressive: bool = False) -> None:
+        """Release memory held by the renderer without destroying the map.
+
+        Tiles and GPU resources that are not in use are released.  GPU
+        resources are freed during the next render, so memoryUsage()
+        reflects the release only after rendering again.
+
+        Parameters
+        ----------
+        aggressive : bool, optional (default: False)
+            if True, release all tiles; these are reloaded when the map
+            is next rendered.
+        """
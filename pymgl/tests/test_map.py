@@ -1,9 +1,11 @@
 import json
+import sqlite3
+from multiprocessing.shared_memory import SharedMemory
 
 import pytest
 import numpy as np
 
-from pymgl import Map
+from pymgl import Map, MBTilesWriter, PMTilesWriter
 
 from .common import MAPBOX_TOKEN, read_style
 
@@ -404,3 +406,544 @@ def test_feature_state_invalid():
 
     with pytest.raises(RuntimeError, match="invalid-layer is not a valid layer"):
         map.removeFeatureState("geojson", "invalid-layer", "0", "a")
+
+
+def test_batch():
+    map = Map(read_style("example-style-geojson.json"))
+
+    with map.batch():
+        map.setPaintProperty("box", "fill-opacity", "0.75")
+        map.setVisibility("box", False)
+        map.addLayer(
+            json.dumps({"id": "points", "source": "geojson", "type": "circle"})
+        )
+
+        # nothing is applied until the batch exits
+        assert map.getPaintProperty("box", "fill-opacity") == "0.5"
+        assert map.getVisibility("box")
+
+    assert map.getPaintProperty("box", "fill-opacity") == "0.75"
+    assert not map.getVisibility("box")
+    assert map.listLayers() == ["box", "box-outline", "points"]
+
+
+def test_batch_invalid():
+    map = Map(read_style("example-style-geojson.json"))
+
+    with pytest.raises(RuntimeError, match="invalid_layer is not a valid layer id"):
+        with map.batch():
+            map.setPaintProperty("box", "fill-opacity", "0.75")
+            map.setVisibility("invalid_layer", False)
+
+    assert map.getPaintProperty("box", "fill-opacity") == "0.5"
+
+    # batch is discarded on exception
+    with pytest.raises(ValueError, match="expected"):
+        with map.batch():
+            map.setVisibility("box", False)
+            raise ValueError("expected")
+
+    assert map.getVisibility("box")
+
+
+def test_apply_style_operations():
+    map = Map(read_style("example-style-geojson.json"))
+
+    map.applyStyleOperations(
+        [
+            ("setPaintProperty", "box", "fill-opacity", "0.75"),
+            ("setVisibility", "box-outline", False),
+            ("setFilter", "box", '["==", "foo", "bar"]'),
+        ]
+    )
+
+    assert map.getPaintProperty("box", "fill-opacity") == "0.75"
+    assert not map.getVisibility("box-outline")
+    assert map.getFilter("box") == '["==", "foo", "bar"]'
+
+    map.applyStyleOperations([("setFilter", "box", None)])
+    assert map.getFilter("box") is None
+
+    with pytest.raises(ValueError, match="unsupported style operation: invalid"):
+        map.applyStyleOperations([("invalid",)])
+
+    with pytest.raises(TypeError, match="must be str, bool, or None"):
+        map.applyStyleOperations([("setPaintProperty", "box", "fill-opacity", 0.5)])
+
+
+def test_set_style():
+    map = Map(read_style("example-style-geojson.json"))
+    map.setPaintProperty("box", "fill-opacity", "0.75")
+
+    map.setStyle(read_style("example-style-geojson-hidden-box.json"))
+    assert map.listLayers() == ["box", "box2", "box-outline"]
+    assert map.getPaintProperty("box", "fill-opacity") == "0.5"
+    assert not map.getVisibility("box2")
+
+    # a style that cannot be applied leaves the previous style intact
+    duplicate = json.dumps(
+        {
+            "version": 8,
+            "sources": {},
+            "layers": [
+                {"id": "background", "type": "background"},
+                {"id": "background", "type": "background"},
+            ],
+        }
+    )
+    with pytest.raises(ValueError, match="duplicate layer id: background"):
+        map.setStyle(duplicate)
+    assert map.listLayers() == ["box", "box2", "box-outline"]
+
+    map.setStyle(read_style("example-style-empty.json"), diff=False)
+    assert map.listLayers() == []
+    assert map.listSources() == []
+
+    with pytest.raises(ValueError, match="style must be a JSON string"):
+        map.setStyle("mapbox://styles/mapbox/streets-v11")
+
+
+def test_stats():
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    assert map.stats["frames"] == 0
+
+    map.renderPNG()
+    stats = map.stats
+    assert stats["frames"] == 1
+    assert stats["last"]["styleLoad"] > 0
+    assert stats["last"]["draw"] > 0
+    assert stats["last"]["readback"] > 0
+    assert stats["last"]["encode"] > 0
+    assert set(stats["last"].keys()) == {
+        "styleLoad",
+        "load",
+        "draw",
+        "readback",
+        "unpremultiply",
+        "encode",
+        "total",
+    }
+
+    map.renderBuffer()
+    assert map.stats["frames"] == 2
+    assert map.stats["last"]["encode"] == 0
+
+    map.resetStats()
+    assert map.stats["frames"] == 0
+
+
+def test_profile_layers():
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    map.setVisibility("box-outline", False)
+
+    layer_times = map.profileLayers(iterations=1)
+    assert list(layer_times.keys()) == ["box", "box-outline"]
+    assert layer_times["box"] >= 0
+    assert layer_times["box-outline"] == 0
+
+    assert map.getVisibility("box")
+    assert not map.getVisibility("box-outline")
+
+    with pytest.raises(ValueError, match="iterations must be greater than 0"):
+        map.profileLayers(iterations=0)
+
+
+def test_profile_layers_visible():
+    # the box fills a large map, so drawing it takes measurable time
+    map = Map(read_style("example-style-geojson.json"), 1024, 1024)
+    map.setBounds(-122, 38.5, -118, 41.5)
+
+    assert map.profileLayers(iterations=5)["box"] > 0
+
+
+def test_memory_usage():
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    usage = map.memoryUsage()
+    assert usage["images"] == 0
+    assert usage["geoJSON"] > 0
+
+    map.addImage("pixel", b"\xff" * 64, 4, 4, 1, False)
+    map.renderPNG()
+
+    usage = map.memoryUsage()
+    assert usage["images"] == 64
+    assert usage["total"] == sum(
+        usage[key] for key in ("textures", "buffers", "images", "geoJSON")
+    )
+
+    map.setStyle(read_style("example-style-empty.json"), diff=False)
+    assert map.memoryUsage()["images"] == 0
+
+
+def test_trim():
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    expected = map.renderBuffer()
+
+    map.trim()
+    map.trim(aggressive=True)
+
+    assert np.array_equal(map.renderBuffer(), expected)
+
+
+def test_source_bounds():
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    assert map.getSourceBounds("geojson") == (-125, 37.5, -115, 42.5)
+
+    map.setGeoJSON("geojson", json.dumps({"type": "Point", "coordinates": [10, 20]}))
+    assert map.getSourceBounds("geojson") == (10, 20, 10, 20)
+
+    map.setGeoJSON("geojson", json.dumps({"type": "FeatureCollection", "features": []}))
+    assert map.getSourceBounds("geojson") is None
+
+    with pytest.raises(RuntimeError, match="invalid is not a valid source"):
+        map.getSourceBounds("invalid")
+
+
+def test_tile_has_data():
+    map = Map(read_style("example-style-geojson.json"), 256, 256)
+    assert map.tileHasData(4, 2, 6)
+    assert not map.tileHasData(4, 10, 6)
+
+    # box is just beyond the west edge of the tile
+    assert not map.tileHasData(4, 3, 6, buffer=0)
+    assert map.tileHasData(4, 3, 6)
+
+    with pytest.raises(ValueError, match="x and y must be less than 2"):
+        map.tileHasData(4, 16, 0)
+
+    with pytest.raises(ValueError, match="buffer must be at least 0"):
+        map.tileHasData(4, 0, 0, buffer=-1)
+
+
+def test_render_many():
+    map = Map(read_style("example-style-geojson.json"), 100, 100, 1, -121, 41, 5)
+    expected = map.renderBuffer()
+
+    map.setCenter(-120, 40)
+    map.setZoom(4)
+
+    frames = map.renderMany(
+        [(-120, 40, 4), (-121, 41, 5), (-120, 40, 4, 90, 30)], format="buffer"
+    )
+    assert len(frames) == 3
+    assert np.array_equal(frames[1], expected)
+    assert not np.array_equal(frames[0], frames[2])
+
+    # camera is restored
+    assert np.allclose(map.center, (-120, 40))
+    assert map.zoom == 4
+
+    pngs = map.renderMany([(-120, 40, 4), (-121, 41, 5)])
+    assert len(pngs) == 2
+    assert pngs[0][1:4] == b"PNG"
+
+    assert map.renderMany([]) == []
+
+    with pytest.raises(ValueError, match="format must be one of"):
+        map.renderMany([(-120, 40, 4)], format="jpg")
+
+    with pytest.raises(ValueError, match="zoom must be no greater than 24"):
+        map.renderMany([(-120, 40, 4), (-120, 40, 25)])
+
+    with pytest.raises(ValueError, match="latitude must be between -90 and 90"):
+        map.renderMany([(-120, 40, 4), (-120, 91, 4)])
+
+    with pytest.raises(ValueError, match="camera must have"):
+        map.renderMany([(-120, 40)])
+
+    with pytest.raises(TypeError):
+        map.renderMany(["abc"])
+
+
+def test_render_path(tmp_path):
+    map = Map(read_style("example-style-geojson.json"), 100, 100, 1, -120, 40, 4)
+    first = map.renderBuffer()
+
+    keyframes = [(0, -120, 40, 4), (1, -115, 38, 5, 10, 30, "ease-in-out")]
+
+    frames = []
+    assert map.renderPath(keyframes, 4, frames.append) == 5
+    assert len(frames) == 5
+    assert len(frames[0]) == 100 * 100 * 4
+    assert np.array_equal(np.frombuffer(frames[0], dtype=np.uint8), first)
+
+    # camera is restored
+    assert np.allclose(map.center, (-120, 40))
+    assert map.zoom == 4
+
+    filename = tmp_path / "frames.rgba"
+    with open(filename, "wb") as f:
+        assert map.renderPath(keyframes, 2, f.fileno()) == 3
+    assert filename.stat().st_size == 3 * 100 * 100 * 4
+
+    def fail(frame):
+        raise KeyError("callback failed")
+
+    with pytest.raises(KeyError, match="callback failed"):
+        map.renderPath(keyframes, 30, fail)
+
+    with pytest.raises(ValueError, match="easing must be one of"):
+        map.renderPath([(0, 0, 0, 0), (1, 0, 0, 1, "bounce")], 30, frames.append)
+
+    with pytest.raises(ValueError, match="keyframe must have"):
+        map.renderPath([(0, 0, 0)], 30, frames.append)
+
+    with pytest.raises(ValueError, match="fps must be greater than 0"):
+        map.renderPath(keyframes, 0, frames.append)
+
+    with pytest.raises(TypeError, match="output must be"):
+        map.renderPath(keyframes, 30, "out.rgba")
+
+    # True is not treated as file descriptor 1
+    with pytest.raises(TypeError, match="output must be"):
+        map.renderPath(keyframes, 30, True)
+
+    with pytest.raises(ValueError, match="latitude must be between -90 and 90"):
+        map.renderPath([(0, 0, 0, 0), (1, 0, 95, 4)], 30, frames.append)
+
+
+def test_render_with_info():
+    map = Map("", 100, 50)
+    map.addLayer(
+        json.dumps(
+            {
+                "id": "background",
+                "type": "background",
+                "paint": {"background-color": "#0000FF"},
+            }
+        )
+    )
+
+    info = map.renderWithInfo()
+    assert info["uniform"]
+    assert info["color"] == (0, 0, 255, 255)
+    assert info["data"][1:4] == b"PNG"
+    assert isinstance(info["hash"], int)
+
+    # same image has same hash
+    assert map.renderWithInfo()["hash"] == info["hash"]
+
+    info = map.renderWithInfo(format="buffer")
+    assert np.array_equal(info["data"], map.renderBuffer())
+
+    map = Map(read_style("example-style-geojson.json"), 100, 50, 1, -120, 40, 4)
+    info = map.renderWithInfo()
+    assert not info["uniform"]
+    assert info["color"] is None
+    assert info["data"] == map.renderPNG()
+
+    with pytest.raises(ValueError, match="format must be one of"):
+        map.renderWithInfo(format="jpg")
+
+
+def test_set_pixel_ratio():
+    map = Map(read_style("example-style-geojson.json"), 100, 50, 1, -120, 40, 4)
+    map.addSource(
+        "point",
+        json.dumps(
+            {"type": "geojson", "data": {"type": "Point", "coordinates": [-120, 40]}}
+        ),
+    )
+    map.addLayer(json.dumps({"id": "point", "type": "circle", "source": "point"}))
+    assert map.pixelRatio == 1
+
+    map.setPixelRatio(2)
+    assert map.pixelRatio == 2
+    assert map.size == (100, 50)
+    assert map.listLayers()[-1] == "point"
+    assert map.renderBuffer().size == 200 * 100 * 4
+
+    with pytest.raises(ValueError, match="ratio must be greater than 0"):
+        map.setPixelRatio(0)
+
+    with pytest.raises(ValueError, match="ratio must be no greater than 8"):
+        map.setPixelRatio(9)
+
+
+def test_render_at_ratios():
+    map = Map(read_style("example-style-geojson.json"), 100, 50, 1, -120, 40, 4)
+    expected = map.renderBuffer()
+
+    frames = map.renderAtRatios([1, 2, 3], format="buffer")
+    assert [frame.size for frame in frames] == [
+        100 * 50 * 4,
+        200 * 100 * 4,
+        300 * 150 * 4,
+    ]
+    assert np.array_equal(frames[0], expected)
+
+    # pixel ratio is restored
+    assert map.pixelRatio == 1
+
+    pngs = map.renderAtRatios([2])
+    assert pngs[0][1:4] == b"PNG"
+
+    with pytest.raises(ValueError, match="format must be one of"):
+        map.renderAtRatios([1], format="jpg")
+
+
+def test_render_region():
+    map = Map(read_style("example-style-geojson.json"), 200, 100, 1, -120, 40, 4)
+    full = map.renderBuffer().reshape(100, 200, 4)
+
+    region = map.renderRegion(50, 20, 100, 60, format="buffer").reshape(60, 100, 4)
+    expected = full[20:80, 50:150]
+    assert np.mean(np.any(region != expected, axis=2)) < 0.01
+
+    # size and camera are restored
+    assert map.size == (200, 100)
+    assert np.allclose(map.center, (-120, 40))
+
+    png = map.renderRegion(0, 0, 100, 100)
+    assert png[1:4] == b"PNG"
+
+    with pytest.raises(ValueError, match="region must be within the size of the map"):
+        map.renderRegion(150, 0, 100, 100)
+
+    map.setPitch(30)
+    with pytest.raises(RuntimeError, match="pitch must be 0"):
+        map.renderRegion(0, 0, 100, 100)
+
+
+def test_render_tiled_png(tmp_path):
+    map = Map(read_style("example-style-geojson.json"), 500, 300, 1, -120, 40, 4)
+
+    filename = tmp_path / "tiled.png"
+    map.renderTiledPNG(str(filename), 1000, 600, tileSize=256, overlap=32)
+
+    data = filename.read_bytes()
+    assert data[1:4] == b"PNG"
+    # width and height from IHDR
+    assert int.from_bytes(data[16:20], "big") == 1000
+    assert int.from_bytes(data[20:24], "big") == 600
+
+    # size is restored
+    assert map.size == (500, 300)
+
+    with pytest.raises(ValueError, match="tileSize must be greater than 0"):
+        map.renderTiledPNG(str(filename), 1000, 600, tileSize=0)
+
+    map.setBearing(90)
+    with pytest.raises(RuntimeError, match="bearing and pitch must be 0"):
+        map.renderTiledPNG(str(filename), 1000, 600)
+
+
+def test_render_tiles(tmp_path):
+    map = Map(read_style("example-style-geojson.json"), 256, 256)
+
+    filename = tmp_path / "tiles.mbtiles"
+    with MBTilesWriter(str(filename), batchSize=2) as writer:
+        writer.setMetadata("format", "png")
+
+        tiles = [(1, x, y) for x in range(2) for y in range(2)]
+        tiles += [(4, 2, 6), (4, 10, 6)]
+        # empty tiles are written with the image of the first of their zoom
+        assert map.renderTiles(tiles, writer, buffer=0) == 6
+        assert map.stats["frames"] == 4
+
+        # empty tiles share one image
+        assert map.renderTiles([(4, 10, 6), (4, 11, 6)], writer, skipEmpty=False) == 2
+        writer.addTile(5, 0, 0, b"data")
+
+        assert writer.tileCount == 9
+        assert writer.imageCount == 4
+
+        with pytest.raises(ValueError, match="x and y must be less than 2"):
+            map.renderTiles([(1, 2, 0)], writer)
+
+        with pytest.raises(ValueError, match="map width must be at least"):
+            map.renderTiles([(0, 0, 0)], writer)
+
+    with pytest.raises(RuntimeError, match="closed"):
+        writer.addTile(0, 0, 0, b"data")
+
+    db = sqlite3.connect(str(filename))
+    metadata = dict(db.execute("SELECT name, value FROM metadata").fetchall())
+    assert metadata == {"format": "png"}
+    assert db.execute("SELECT COUNT(*) FROM tiles").fetchone() == (8,)
+
+    # rows are in the TMS scheme
+    (data,) = db.execute(
+        "SELECT tile_data FROM tiles "
+        "WHERE zoom_level = 4 AND tile_column = 2 AND tile_row = 9"
+    ).fetchone()
+    assert data[1:4] == b"PNG"
+    db.close()
+
+
+def test_render_tiles_pmtiles(tmp_path):
+    map = Map(read_style("example-style-geojson.json"), 256, 256)
+
+    filename = tmp_path / "tiles.pmtiles"
+    with PMTilesWriter(str(filename)) as writer:
+        writer.setMetadata("name", "example")
+
+        # tiles may be rendered in any order; empty tiles share one image
+        tiles = [(4, 11, 6), (4, 10, 6), (1, 0, 0)]
+        assert map.renderTiles(tiles, writer, skipEmpty=False) == 3
+
+        assert writer.tileCount == 3
+        assert writer.imageCount == 2
+
+    with pytest.raises(RuntimeError, match="closed"):
+        writer.addTile(0, 0, 0, b"data")
+
+    data = filename.read_bytes()
+    assert data[:8] == b"PMTiles\x03"
+
+
+def test_render_png_to_file(tmp_path):
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    expected = map.renderPNG()
+
+    filename = tmp_path / "map.png"
+    map.renderPNGToFile(filename)
+    data = filename.read_bytes()
+    assert data[1:4] == b"PNG"
+    assert int.from_bytes(data[16:20], "big") == 100
+
+    map.renderPNGToFile(str(filename))
+    assert filename.stat().st_size > 0
+
+    # the file descriptor is left open
+    with open(filename, "wb") as f:
+        map.renderPNGToFile(f.fileno())
+        assert not f.closed
+
+    # same settings as renderPNG, so output is the same
+    assert filename.read_bytes() == expected
+
+    with pytest.raises(RuntimeError, match="could not open"):
+        map.renderPNGToFile(tmp_path / "invalid" / "map.png")
+
+    # True is not treated as file descriptor 1
+    with pytest.raises(TypeError, match="output must be a path or file descriptor"):
+        map.renderPNGToFile(True)
+
+
+def test_render_to_shared_memory():
+    map = Map(read_style("example-style-geojson.json"), 100, 50)
+    expected = map.renderBuffer()
+
+    name = "pymgl-test-frame"
+    assert map.renderToSharedMemory(name) == 2
+
+    shm = SharedMemory(name=name)
+    try:
+        assert bytes(shm.buf[:4]) == b"MGLF"
+        width, height = np.frombuffer(shm.buf, np.uint32, 2, 8)
+        assert (width, height) == (100, 50)
+        offset = int(np.frombuffer(shm.buf, np.uint64, 1, 24)[0])
+        img = np.frombuffer(shm.buf, np.uint8, width * height * 4, offset)
+        assert np.array_equal(img, expected)
+        del img
+
+        assert map.renderToSharedMemory(name) == 4
+        assert int(np.frombuffer(shm.buf, np.uint64, 1, 32)[0]) == 4
+
+    finally:
+        shm.close()
+        shm.unlink()
+
+    with pytest.raises(ValueError, match="must be non-empty"):
+        map.renderToSharedMemory("pymgl/frame")
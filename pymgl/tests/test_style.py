@@ -139,6 +139,24 @@ def test_local_mbtiles_vector_source():
     assert image_matches(img_data, f"{test}.png", 100)
 
 
+def test_source_stats():
+    test = "example-style-mbtiles-vector-source"
+    style = read_style(f"{test}.json")
+    style = style.replace("mbtiles://", f"mbtiles://{FIXTURES_PATH}/")
+
+    map = Map(style, 256, 256)
+    source_id = map.listSources()[0]
+    assert map.getSourceStats()[source_id]["requests"] == 0
+
+    map.renderPNG()
+    stats = map.getSourceStats()[source_id]
+    assert stats["requests"] > 1
+    assert stats["tiles"] > 0
+    assert stats["bytes"] > 0
+    assert stats["errors"] == 0
+    assert stats["loadTime"] > 0
+
+
 def test_local_mbtiles_vector_source_2x():
     test = "example-style-mbtiles-vector-source"
     style = read_style(f"{test}.json")
@@ -314,3 +332,18 @@ def test_add_geojson_point_layer():
     img_data = map.renderPNG()
 
     assert image_matches(img_data, f"{test}.png")
+
+
+def test_set_style_diff():
+    test = "example-style-geojson-hidden-box"
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    map.setBounds(-125, 37.5, -115, 42.5)
+    map.renderPNG()
+
+    map.setStyle(read_style(f"{test}.json"))
+    map.setVisibility("box", False)
+    map.setVisibility("box2", True)
+
+    img_data = map.renderPNG()
+
+    assert image_matches(img_data, f"{test}.png")
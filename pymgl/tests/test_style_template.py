@@ -0,0 +1,49 @@
+import pytest
+
+from pymgl import Map, StyleTemplate
+
+from .common import image_matches, read_style
+
+
+def test_style_template():
+    style = StyleTemplate(read_style("example-style-geojson.json"))
+    assert style.listLayers() == ["box", "box-outline"]
+    assert style.listSources() == ["geojson"]
+
+    map = Map(style, 10, 20)
+    assert map.size == (10, 20)
+    assert map.listLayers() == ["box", "box-outline"]
+    assert map.listSources() == ["geojson"]
+
+    # modifying one map does not modify other maps created from the template
+    map.setPaintProperty("box", "fill-opacity", "0.75")
+    assert Map(style).getPaintProperty("box", "fill-opacity") == "0.5"
+
+
+def test_style_template_invalid():
+    with pytest.raises(ValueError, match="error parsing style"):
+        StyleTemplate("{")
+
+    with pytest.raises(ValueError, match="style layers must be an array"):
+        StyleTemplate('{"version": 8, "sources": {}, "layers": {}}')
+
+
+def test_style_template_cache():
+    StyleTemplate.clearCache()
+    assert StyleTemplate.cacheSize() == 0
+
+    style = read_style("example-style-geojson.json")
+    assert StyleTemplate.get(style) is StyleTemplate.get(style)
+    assert StyleTemplate.cacheSize() == 1
+
+    StyleTemplate.clearCache()
+    assert StyleTemplate.cacheSize() == 0
+
+
+def test_style_template_render():
+    test = "example-style-geojson"
+    map = Map(StyleTemplate.get(read_style(f"{test}.json")), 100, 100)
+    map.setBounds(-125, 37.5, -115, 42.5)
+    img_data = map.renderPNG()
+
+    assert image_matches(img_data, f"{test}.png")
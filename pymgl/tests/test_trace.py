@@ -0,0 +1,42 @@
+import json
+
+from pymgl import Map, getTraceJSON, startTracing, stopTracing
+
+from .common import read_style
+
+
+def test_trace():
+    startTracing()
+    map = Map(read_style("example-style-geojson.json"), 100, 100)
+    map.renderPNG()
+    stopTracing()
+
+    trace = json.loads(getTraceJSON())
+    names = {event["name"] for event in trace["traceEvents"]}
+    assert {"Map", "loadStyle", "renderPNG", "draw", "encode"}.issubset(names)
+
+    spans = [event for event in trace["traceEvents"] if event["ph"] == "X"]
+    assert all(event["dur"] >= 0 for event in spans)
+
+    # render phases are measured, so their spans are not empty
+    phases = [e for e in spans if e["name"] in {"load", "draw", "readback"}]
+    assert {e["name"] for e in phases} >= {"draw", "readback"}
+    assert all(e["dur"] > 0 for e in phases)
+
+
+def test_trace_capacity():
+    startTracing(capacity=2)
+    Map(read_style("example-style-geojson.json"), 100, 100).renderPNG()
+    stopTracing()
+
+    trace = json.loads(getTraceJSON())
+    assert len([e for e in trace["traceEvents"] if e["ph"] != "M"]) == 2
+
+
+def test_trace_stopped():
+    startTracing()
+    stopTracing()
+    Map(read_style("example-style-geojson.json"), 100, 100).renderPNG()
+
+    trace = json.loads(getTraceJSON())
+    assert [e for e in trace["traceEvents"] if e["ph"] != "M"] == []
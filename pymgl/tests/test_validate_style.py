@@ -0,0 +1,36 @@
+import json
+
+from pymgl import validateStyle
+
+from .common import read_style
+
+
+def test_validate_style_valid(empty_style):
+    assert validateStyle(empty_style) == []
+    assert validateStyle(read_style("example-style-geojson.json")) == []
+
+
+def test_validate_style_invalid_json():
+    errors = validateStyle("{")
+    assert len(errors) == 1
+    assert errors[0]["type"] == "style"
+    assert errors[0]["id"] is None
+    assert errors[0]["message"].startswith("error parsing style")
+
+
+def test_validate_style_invalid():
+    style = {
+        "version": 8,
+        "sources": {"invalid": {"type": "invalid"}},
+        "layers": [
+            {"id": "background", "type": "background"},
+            {"id": "missing", "type": "fill", "source": "missing"},
+        ],
+    }
+    errors = validateStyle(json.dumps(style))
+
+    assert [(e["type"], e["id"]) for e in errors] == [
+        ("source", "invalid"),
+        ("layer", "missing"),
+    ]
+    assert errors[1]["message"] == "source missing is not in the style"
@@ -3,17 +3,167 @@
 #include <nanobind/ndarray.h>
 #include <nanobind/stl/optional.h>
 #include <nanobind/stl/pair.h>
+#include <nanobind/stl/shared_ptr.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <sstream>
 
 #include "log_observer.h"
 #include "map.h"
+#include "mbtiles_writer.h"
+#include "pmtiles_writer.h"
+#include "style.h"
+#include "trace.h"
 
 namespace nb = nanobind;
 using namespace nanobind::literals;
 using namespace mgl_wrapper;
 
+nb::dict toDict(const RenderPhases &phases) {
+    nb::dict out;
+    out["styleLoad"]     = phases.styleLoad;
+    out["load"]          = phases.load;
+    out["draw"]          = phases.draw;
+    out["readback"]      = phases.readback;
+    out["unpremultiply"] = phases.unpremultiply;
+    out["encode"]        = phases.encode;
+    out["total"]         = phases.total;
+    return out;
+}
+
+// Context manager returned by Map.batch(); style mutations made within the
+// context are queued and applied together when the context exits.
+struct StyleBatch {
+    Map &map;
+};
+
+// Convert a Python sequence of (type, *args) into a StyleOperation; bools are
+// encoded as "true" / "false" and None as an empty string.
+StyleOperation toStyleOperation(nb::handle item) {
+    if (!nb::isinstance<nb::sequence>(item) || nb::isinstance<nb::str>(item)) {
+        throw nb::type_error("each style operation must be a tuple of (type, *args)");
+    }
+
+    StyleOperation operation;
+    bool first = true;
+    for (nb::handle value : item) {
+        std::string arg;
+        if (value.is_none()) {
+            arg = "";
+        } else if (nb::isinstance<nb::bool_>(value)) {
+            arg = nb::cast<bool>(value) ? "true" : "false";
+        } else if (nb::isinstance<nb::str>(value)) {
+            arg = nb::cast<std::string>(value);
+        } else {
+            throw nb::type_error("style operation arguments must be str, bool, or None");
+        }
+
+        if (first) {
+            operation.type = arg;
+            first          = false;
+        } else {
+            operation.args.push_back(arg);
+        }
+    }
+
+    if (first) {
+        throw nb::type_error("style operation must not be empty");
+    }
+
+    return operation;
+}
+
+// Convert a Python sequence of (longitude, latitude, zoom[, bearing[, pitch]])
+// into a Camera
+Camera toCamera(nb::handle item) {
+    if (!nb::isinstance<nb::sequence>(item) || nb::isinstance<nb::str>(item)) {
+        throw nb::type_error(
+            "each camera must be a tuple of (longitude, latitude, zoom, bearing, pitch)");
+    }
+
+    std::vector<double> values;
+    for (nb::handle value : item) {
+        values.push_back(nb::cast<double>(value));
+    }
+    if (values.size() < 3 || values.size() > 5) {
+        throw std::invalid_argument(
+            "camera must have longitude, latitude, zoom, and optionally bearing and pitch");
+    }
+
+    Camera camera{values[0], values[1], values[2]};
+    if (values.size() > 3) {
+        camera.bearing = values[3];
+    }
+    if (values.size() > 4) {
+        camera.pitch = values[4];
+    }
+    return camera;
+}
+
+// Convert a Python sequence of (time, longitude, latitude, zoom[, bearing[,
+// pitch]][, easing]) into a Keyframe
+Keyframe toKeyframe(nb::handle item) {
+    if (!nb::isinstance<nb::sequence>(item) || nb::isinstance<nb::str>(item)) {
+        throw nb::type_error("each keyframe must be a tuple of (time, longitude, latitude, zoom, "
+                             "bearing, pitch, easing)");
+    }
+
+    std::vector<double> values;
+    Keyframe keyframe{0, {0, 0, 0}};
+    for (nb::handle value : item) {
+        if (nb::isinstance<nb::str>(value)) {
+            keyframe.easing = nb::cast<std::string>(value);
+        } else {
+            values.push_back(nb::cast<double>(value));
+        }
+    }
+    if (values.size() < 4 || values.size() > 6) {
+        throw std::invalid_argument("keyframe must have time, longitude, latitude, zoom, and "
+                                    "optionally bearing, pitch, and easing");
+    }
+
+    keyframe.time   = values[0];
+    keyframe.camera = Camera{values[1], values[2], values[3]};
+    if (values.size() > 4) {
+        keyframe.camera.bearing = values[4];
+    }
+    if (values.size() > 5) {
+        keyframe.camera.pitch = values[5];
+    }
+    return keyframe;
+}
+
+// Convert a Python sequence of (z, x, y) into a TileID
+TileID toTileID(nb::handle item) {
+    if (!nb::isinstance<nb::sequence>(item) || nb::isinstance<nb::str>(item)) {
+        throw nb::type_error("each tile must be a tuple of (z, x, y)");
+    }
+
+    std::vector<uint32_t> values;
+    for (nb::handle value : item) {
+        values.push_back(nb::cast<uint32_t>(value));
+    }
+    if (values.size() != 3) {
+        throw std::invalid_argument("tile must have z, x, and y");
+    }
+    return TileID{values[0], values[1], values[2]};
+}
+
+// Move a frame rendered as format "png" or "buffer" into bytes or a numpy array
+// of uint8 pixel values
+nb::object toFrame(std::string &&frame, const std::string &format) {
+    if (format == "png") {
+        return nb::bytes(frame.c_str(), frame.size());
+    }
+
+    // move pixels into a numpy array owned by a capsule, as for renderBuffer
+    auto data       = new std::string(std::move(frame));
+    size_t shape[1] = {data->size()};
+    nb::capsule owner(data, [](void *p) noexcept { delete reinterpret_cast<std::string *>(p); });
+    return nb::cast(nb::ndarray<nb::numpy, uint8_t, nb::shape<1>>(
+        reinterpret_cast<uint8_t *>(data->data()), 1, shape, owner));
+}
+
 NB_MODULE(_pymgl, m) {
     // Setup logging when module is imported
     // TODO: pass errors / warnings back to Python
@@ -21,6 +171,249 @@ NB_MODULE(_pymgl, m) {
 
     m.doc() = "MapLibre Native static renderer";
 
+    nb::class_<StyleBatch>(m, "StyleBatch")
+        .def("__enter__",
+             [](StyleBatch &self) {
+                 self.map.beginBatch();
+                 return &self;
+             })
+        .def(
+            "__exit__",
+            [](StyleBatch &self,
+               nb::object exc_type  = nb::none(),
+               nb::object exc_value = nb::none(),
+               nb::object traceback = nb::none()) {
+                if (exc_type.is_none()) {
+                    self.map.commitBatch();
+                } else {
+                    self.map.discardBatch();
+                }
+            },
+            nb::arg("exc_type").none(),
+            nb::arg("exc_value").none(),
+            nb::arg("traceback").none());
+
+    m.def(
+        "validateStyle",
+        [](const std::string &style) {
+            std::vector<StyleError> errors;
+            {
+                // release the GIL while validating
+                nb::gil_scoped_release release;
+                errors = validateStyle(style);
+            }
+
+            nb::list out;
+            for (const auto &error : errors) {
+                nb::dict item;
+                item["type"] = error.type;
+                if (error.id.empty()) {
+                    item["id"] = nb::none();
+                } else {
+                    item["id"] = error.id;
+                }
+                item["message"] = error.message;
+                out.append(item);
+            }
+            return out;
+        },
+        R"pbdoc(
+            Validate a style without creating a map.
+
+            Sources, layers, filters, and expressions are validated using the
+            same conversions as loading a style into a map.  Remote resources
+            are not fetched.
+
+            Parameters
+            ----------
+            style : str
+                Mapbox GL / Maplibre GL style object as json-encoded string.
+
+            Returns
+            -------
+            list of dict
+                One entry per error with keys "type" ("style", "source", or
+                "layer"), "id" (source or layer ID, or None), and "message".
+                Empty if the style is valid.
+        )pbdoc",
+        nb::arg("style"));
+
+    m.def("startTracing",
+          &tracing::start,
+          R"pbdoc(
+            Start recording trace events for all maps.
+
+            Spans are recorded for map construction, style loads, and each
+            phase of rendering, with instant events for map and log events.
+            Only the most recent events are kept once capacity is reached.
+            Any previously recorded events are discarded.
+
+            Parameters
+            ----------
+            capacity : int, optional (default: 100000)
+                maximum number of events to keep
+        )pbdoc",
+          nb::arg("capacity") = 100000);
+
+    m.def("stopTracing",
+          &tracing::stop,
+          R"pbdoc(
+            Stop recording trace events; recorded events are kept until
+            tracing is started again.
+        )pbdoc");
+
+    m.def("getTraceJSON",
+          &tracing::toJSON,
+          R"pbdoc(
+            Return recorded trace events as Chrome trace JSON.
+
+            The JSON can be loaded into Perfetto (https://ui.perfetto.dev) or
+            chrome://tracing.
+
+            Returns
+            -------
+            str
+        )pbdoc");
+
+    nb::class_<StyleTemplate>(m, "StyleTemplate")
+        .def(nb::init<const std::string &>(),
+             R"pbdoc(
+            Parse and validate a style once so that it can be used to create
+            many maps without parsing it again.
+
+            Layers are shared between maps until a map modifies them.
+
+            Parameters
+            ----------
+            style : str
+                Mapbox GL / Maplibre GL style object as json-encoded string.
+        )pbdoc",
+             nb::arg("style"))
+        .def_static("get",
+                    &StyleTemplate::get,
+                    R"pbdoc(
+                Return a template for the style, reusing a cached template if
+                one was already created for identical style JSON.
+
+                Parameters
+                ----------
+                style : str
+                    Mapbox GL / Maplibre GL style object as json-encoded string.
+
+                Returns
+                -------
+                StyleTemplate
+            )pbdoc",
+                    nb::arg("style"))
+        .def_static("clearCache", &StyleTemplate::clearCache)
+        .def_static("cacheSize", &StyleTemplate::cacheSize)
+        .def("listLayers", &StyleTemplate::listLayers)
+        .def("listSources", &StyleTemplate::listSources);
+
+    nb::class_<TileWriter>(m, "TileWriter")
+        .def("__enter__", [](TileWriter &self) { return &self; })
+        .def(
+            "__exit__",
+            [](TileWriter &self,
+               nb::object exc_type  = nb::none(),
+               nb::object exc_value = nb::none(),
+               nb::object traceback = nb::none()) { self.close(); },
+            nb::arg("exc_type").none(),
+            nb::arg("exc_value").none(),
+            nb::arg("traceback").none())
+        .def("setMetadata",
+             &TileWriter::setMetadata,
+             R"pbdoc(
+            Set a metadata value, such as name, format, or attribution.
+
+            Parameters
+            ----------
+            name : str
+            value : str
+        )pbdoc",
+             nb::arg("name"),
+             nb::arg("value"))
+        .def(
+            "addTile",
+            [](TileWriter &self,
+               uint32_t z,
+               uint32_t x,
+               uint32_t y,
+               nb::bytes &data,
+               const std::optional<uint64_t> &hash) {
+                // convert bytes to std::string
+                const std::string dataStr(data.c_str(), data.size());
+                if (hash) {
+                    self.addTile(z, x, y, dataStr, *hash);
+                } else {
+                    self.addTile(z, x, y, dataStr);
+                }
+            },
+            R"pbdoc(
+            Add the image of a tile.
+
+            Parameters
+            ----------
+            z : int
+            x : int
+            y : int
+                tile in the XYZ scheme.
+            data : bytes
+                encoded image of the tile.
+            hash : int, optional (default: None)
+                hash of data used to find identical images, such as the hash
+                returned by Map.renderWithInfo(); data is hashed if None.
+                Images with the same hash are compared before they are shared.
+        )pbdoc",
+            nb::arg("z"),
+            nb::arg("x"),
+            nb::arg("y"),
+            nb::arg("data"),
+            nb::arg("hash") = nb::none())
+        .def("flush", &TileWriter::flush, "Write pending tiles.")
+        .def("close", &TileWriter::close, "Finish writing the file.")
+        .def_prop_ro("tileCount", &TileWriter::getTileCount)
+        .def_prop_ro("imageCount", &TileWriter::getImageCount);
+
+    nb::class_<MBTilesWriter, TileWriter>(m, "MBTilesWriter")
+        .def(nb::init<const std::string &, uint32_t>(),
+             R"pbdoc(
+            Write raster tiles to an MBTiles file.
+
+            Tiles are stored in the TMS scheme used by MBTiles.  Tiles with
+            identical images share a single stored image, and tiles are
+            committed in transactions of batchSize tiles.  An existing file
+            written by MBTilesWriter is added to, replacing tiles that are
+            written again.  Use as a context manager, or call close() when
+            done; close() also deletes images no longer used by any tile.
+
+            Parameters
+            ----------
+            filename : str
+                path of the MBTiles file to create or add to.
+            batchSize : int, optional (default: 1000)
+                number of tiles to commit in each transaction.
+        )pbdoc",
+             nb::arg("filename"),
+             nb::arg("batchSize") = 1000);
+
+    nb::class_<PMTilesWriter, TileWriter>(m, "PMTilesWriter")
+        .def(nb::init<const std::string &>(),
+             R"pbdoc(
+            Write tiles to a PMTiles v3 archive.
+
+            Tiles may be added in any order.  Tiles with identical images share
+            a single stored image, and the archive is written when closed, with
+            tiles clustered in Hilbert order.  An existing file is replaced.
+            Use as a context manager, or call close() when done.
+
+            Parameters
+            ----------
+            filename : str
+                path of the PMTiles file to create.
+        )pbdoc",
+             nb::arg("filename"));
+
     nb::class_<Map>(m, "Map")
         .def(nb::init<const std::string &,
                       const std::optional<uint32_t> &,
@@ -36,8 +429,9 @@ NB_MODULE(_pymgl, m) {
 
             Parameters
             ----------
-            style : str
-                Mapbox GL / Maplibre GL style object as json-encoded string.
+            style : str or StyleTemplate
+                Mapbox GL / Maplibre GL style object as json-encoded string, or
+                a style template.
             width : int, optional (default: 256)
                 Width of output map.
             height : int, optional (default: 256)
@@ -64,6 +458,24 @@ NB_MODULE(_pymgl, m) {
              nb::arg("zoom")      = 0,
              nb::arg("token")     = nb::none(),
              nb::arg("provider")  = nb::none())
+        .def(nb::init<const std::shared_ptr<StyleTemplate> &,
+                      const std::optional<uint32_t> &,
+                      const std::optional<uint32_t> &,
+                      const std::optional<float> &,
+                      const std::optional<double> &,
+                      const std::optional<double> &,
+                      const std::optional<double> &,
+                      const std::optional<std::string> &,
+                      const std::optional<std::string> &>(),
+             nb::arg("style"),
+             nb::arg("width")     = 256,
+             nb::arg("height")    = 256,
+             nb::arg("ratio")     = 1,
+             nb::arg("longitude") = 0,
+             nb::arg("latitude")  = 0,
+             nb::arg("zoom")      = 0,
+             nb::arg("token")     = nb::none(),
+             nb::arg("provider")  = nb::none())
         .def("__str__",
              [](Map &self) {
                  std::ostringstream os;
@@ -146,11 +558,67 @@ NB_MODULE(_pymgl, m) {
                     JSON-encoded layer options.  Fields are specific to the layer type.
             )pbdoc",
              nb::arg("options"))
+        .def(
+            "applyStyleOperations",
+            [](Map &self, nb::iterable operations) {
+                std::vector<StyleOperation> ops;
+                for (nb::handle item : operations) {
+                    ops.push_back(toStyleOperation(item));
+                }
+                self.applyStyleOperations(ops);
+            },
+            R"pbdoc(
+                Validate and apply a list of style operations in a single call.
+
+                No operations are applied if any of them are invalid.
+
+                Parameters
+                ----------
+                operations : list of tuples
+                    Each tuple is the name of a style method followed by its
+                    arguments, e.g., ("setPaintProperty", "box", "fill-opacity", "0.5").
+                    Supported methods are addSource, addLayer, setFilter,
+                    setPaintProperty, and setVisibility.
+            )pbdoc",
+            nb::arg("operations"))
+        .def(
+            "batch",
+            [](Map &self) { return StyleBatch{self}; },
+            nb::keep_alive<0, 1>(),
+            R"pbdoc(
+                Return a context manager that queues style mutations made within
+                it and validates and applies them together on exit.
+
+                Getters return the style as it was before the batch until the
+                batch is applied.  No mutations are applied if any are invalid
+                or if an exception is raised within the context.
+            )pbdoc")
         .def_prop_ro("bearing", &Map::getBearing)
         .def_prop_ro("center", &Map::getCenter)
         .def_prop_ro("pitch", &Map::getPitch)
+        .def_prop_ro("pixelRatio", &Map::getPixelRatio)
         .def_prop_ro("size", &Map::getSize)
         .def_prop_ro("zoom", &Map::getZoom)
+        .def_prop_ro(
+            "stats",
+            [](Map &self) {
+                RenderStats stats = self.getStats();
+                nb::dict out;
+                out["frames"]     = stats.frames;
+                out["last"]       = toDict(stats.last);
+                out["cumulative"] = toDict(stats.cumulative);
+                return out;
+            },
+            R"pbdoc(
+                Time spent in each phase of rendering, in milliseconds.
+
+                Returns a dict with the number of frames rendered, and the
+                phases of the last render and cumulative phases of all renders.
+                Phases are styleLoad, load (fetching resources, parsing
+                tiles, and layout), draw, readback, unpremultiply, encode, and
+                total.
+            )pbdoc")
+        .def("resetStats", &Map::resetStats)
         .def("getFeatureState",
              &Map::getFeatureState,
              R"pbdoc(
@@ -239,7 +707,164 @@ NB_MODULE(_pymgl, m) {
              nb::arg("layerID"))
         .def("listLayers", &Map::listLayers)
         .def("listSources", &Map::listSources)
+        .def(
+            "getSourceStats",
+            [](Map &self) {
+                nb::dict out;
+                for (const auto &[sourceID, stats] : self.getSourceStats()) {
+                    nb::dict item;
+                    item["requests"]    = stats.requests;
+                    item["tiles"]       = stats.tiles;
+                    item["bytes"]       = stats.bytes;
+                    item["errors"]      = stats.errors;
+                    item["notModified"] = stats.notModified;
+                    item["loadTime"]    = stats.loadTime;
+
+                    out[sourceID.c_str()] = item;
+                }
+                return out;
+            },
+            R"pbdoc(
+                Return resources loaded for each source since the map was created.
+
+                Responses are attributed to a source by its tile URLs, tileset
+                URL, or GeoJSON data URL.
+
+                Returns
+                -------
+                dict
+                    source ID to dict of requests (responses received, including
+                    tilesets and data), tiles (distinct tiles requested), bytes,
+                    errors, notModified (responses confirming that a cached
+                    resource is still valid), and loadTime (total time from
+                    request to response, in milliseconds).
+            )pbdoc")
+        .def(
+            "getSourceBounds",
+            [](Map &self, const std::string &sourceID) -> nb::object {
+                auto bounds = self.getSourceBounds(sourceID);
+                if (!bounds) {
+                    return nb::none();
+                }
+                return nb::make_tuple(bounds->west, bounds->south, bounds->east, bounds->north);
+            },
+            R"pbdoc(
+                Return the extent of the data of a source.
+
+                The extent is read from the bounds of a tileset, including
+                tilesets loaded from a URL such as mbtiles metadata, or from the
+                coordinates of GeoJSON data or an image source.  Tilesets loaded
+                from a URL are only known once the style has loaded; call load()
+                first.
+
+                Parameters
+                ----------
+                sourceID : str
+                    ID of source
+
+                Returns
+                -------
+                tuple or None
+                    (west, south, east, north) in degrees, or None if the extent
+                    is not known or the source has no data.
+            )pbdoc",
+            nb::arg("sourceID"))
+        .def("tileHasData",
+             &Map::tileHasData,
+             R"pbdoc(
+                Return False if no source has data within a tile.
+
+                Use this to skip rendering tiles outside of the data of sparse
+                sources when rendering a tile pyramid, or to fill them with the
+                background instead.  This only uses the extent of each source
+                (see getSourceBounds()), so it may return True for tiles within
+                the extent that are empty.  Sources of unknown extent are
+                assumed to have data everywhere.
+
+                Parameters
+                ----------
+                z : int
+                x : int
+                y : int
+                    tile coordinates
+                buffer : float, optional (default: 0.25)
+                    fraction of the width of the tile to expand it by on each
+                    side, to include features drawn beyond their coordinates,
+                    such as labels and wide lines.
+
+                Returns
+                -------
+                bool
+            )pbdoc",
+             nb::arg("z"),
+             nb::arg("x"),
+             nb::arg("y"),
+             nb::arg("buffer") = 0.25)
         .def("load", &Map::load)
+        .def(
+            "memoryUsage",
+            [](Map &self) {
+                MemoryUsage usage = self.memoryUsage();
+                nb::dict out;
+                out["textures"] = usage.textures;
+                out["buffers"]  = usage.buffers;
+                out["images"]   = usage.images;
+                out["geoJSON"]  = usage.geoJSON;
+                out["total"]    = usage.textures + usage.buffers + usage.images + usage.geoJSON;
+                return out;
+            },
+            R"pbdoc(
+                Return memory held by the map, in bytes.
+
+                GPU memory is as of the most recent render.  Glyph and sprite
+                atlases are held as textures.
+
+                Returns
+                -------
+                dict
+                    textures, buffers (vertex, index, and uniform buffers),
+                    images (images added to the style), geoJSON (GeoJSON data
+                    held by sources, as encoded JSON), and total.
+            )pbdoc")
+        .def(
+            "profileLayers",
+            [](Map &self, uint32_t iterations) {
+                std::vector<std::pair<std::string, double>> layerTimes;
+                {
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    layerTimes = self.profileLayers(iterations);
+                }
+
+                nb::dict out;
+                for (const auto &[layerID, time] : layerTimes) {
+                    out[layerID.c_str()] = time;
+                }
+                return out;
+            },
+            R"pbdoc(
+                Measure the time each layer adds to drawing the map.
+
+                The map is rendered with all layers and then with each visible
+                layer hidden in turn; the difference in wall-clock time to
+                render the frame, which includes waiting for the GPU, is
+                attributed to that layer.  Times are not measured with GPU timer
+                queries and are not broken down by render pass, so they are
+                approximate and do not add up to the total time to draw the map.
+
+                Parameters
+                ----------
+                iterations : int, optional (default: 3)
+                    number of frames to render for each layer; the median time
+                    is used.
+
+                Returns
+                -------
+                dict
+                    layer ID to time in milliseconds, in style order.  Layers
+                    that are not visible take no time.
+            )pbdoc",
+            nb::arg("iterations") = 3)
         .def("removeFeatureState",
              &Map::removeFeatureState,
              R"pbdoc(
@@ -287,6 +912,88 @@ NB_MODULE(_pymgl, m) {
             R"pbdoc(
                 Render the map to PNG bytes.
             )pbdoc")
+        .def(
+            "renderPNGToFile",
+            [](Map &self, nb::object output) {
+                // bool is a subclass of int, but True is not meant as stdout
+                if (nb::isinstance<nb::bool_>(output)) {
+                    throw nb::type_error("output must be a path or file descriptor");
+                }
+
+                if (nb::isinstance<nb::int_>(output)) {
+                    const int fd = nb::cast<int>(output);
+
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    self.renderPNGToFile(fd);
+                    return;
+                }
+
+                // accept str or os.PathLike
+                const std::string filename
+                    = nb::cast<std::string>(nb::module_::import_("os").attr("fspath")(output));
+
+                nb::gil_scoped_release release;
+                self.renderPNGToFile(filename);
+            },
+            R"pbdoc(
+                Render the map to PNG, writing it to a file or file descriptor.
+
+                Rows of the image are encoded and written as they are produced
+                instead of first encoding the whole image in memory, and the GIL
+                is released while rendering and writing.
+
+                Parameters
+                ----------
+                output : str, os.PathLike, or int
+                    path of the file to write, or a file descriptor such as a
+                    socket or pipe.  A file descriptor is not closed.
+            )pbdoc",
+            nb::arg("output"))
+        .def(
+            "renderToSharedMemory",
+            [](Map &self, const std::string &name) {
+                // release the GIL while rendering
+                nb::gil_scoped_release release;
+                return self.renderToSharedMemory(name);
+            },
+            R"pbdoc(
+                Render the map into a named shared memory segment, so that other
+                processes can read the frame without copying or encoding it.
+
+                The segment is created if needed.  If the size of the map changed
+                since the previous frame, the segment is unlinked and replaced,
+                so readers must open it again.  The segment is not removed when
+                the map is deleted; the reader should unlink it once done.
+
+                The segment starts with a 64 byte header of native endian fields:
+                magic ``b"MGLF"`` (0), version, width, height, stride, and format
+                as uint32 (4-20), pixel data offset as uint64 (24), sequence as
+                uint64 (32), and pixel ratio as float32 (40).  Pixels are
+                unpremultiplied RGBA.
+
+                The sequence is odd while a frame is being written; readers should
+                check that it is even and unchanged after copying pixels.
+
+                Parameters
+                ----------
+                name : str
+                    name of the segment, as used by
+                    ``multiprocessing.shared_memory.SharedMemory``
+
+                Returns
+                -------
+                int
+                    sequence number of the frame
+
+                Examples
+                --------
+                >>> map.renderToSharedMemory("pymgl-frame")
+                >>> shm = SharedMemory(name="pymgl-frame")
+                >>> width, height = np.frombuffer(shm.buf, np.uint32, 2, 8)
+                >>> img = np.frombuffer(shm.buf, np.uint8, width * height * 4, 64)
+            )pbdoc",
+            nb::arg("name"))
         .def(
             "renderBuffer",
             [](Map &self) {
@@ -317,6 +1024,340 @@ NB_MODULE(_pymgl, m) {
             R"pbdoc(
                 Render the map to a numpy array of uint8 pixel values.
             )pbdoc")
+        .def(
+            "renderMany",
+            [](Map &self, nb::iterable cameras, const std::string &format) {
+                std::vector<Camera> frameCameras;
+                for (nb::handle item : cameras) {
+                    frameCameras.push_back(toCamera(item));
+                }
+
+                std::vector<std::string> frames;
+                {
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    frames = self.renderMany(frameCameras, format);
+                }
+
+                nb::list out;
+                for (auto &frame : frames) {
+                    out.append(toFrame(std::move(frame), format));
+                }
+                return out;
+            },
+            R"pbdoc(
+                Render a frame for each camera in a single call.
+
+                Tiles, glyphs, and sprites loaded for earlier frames are reused
+                by later frames, and the GIL is released while rendering all
+                frames.  The camera of the map is restored afterwards.
+
+                Parameters
+                ----------
+                cameras : list of tuples
+                    Each tuple is (longitude, latitude, zoom) with optional
+                    bearing and pitch, e.g., (-120, 40, 5, 0, 45).
+                format : str, optional (default: "png")
+                    "png" to return PNG bytes, or "buffer" to return numpy
+                    arrays of uint8 pixel values as for renderBuffer().
+
+                Returns
+                -------
+                list
+                    one frame for each camera, in order.
+            )pbdoc",
+            nb::arg("cameras"),
+            nb::arg("format") = "png")
+        .def(
+            "renderWithInfo",
+            [](Map &self, const std::string &format) {
+                RenderedImage image;
+                {
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    image = self.renderWithInfo(format);
+                }
+
+                nb::dict out;
+                out["uniform"] = image.uniformColor.has_value();
+                out["color"]   = nb::none();
+                if (image.uniformColor) {
+                    const Color &color = *image.uniformColor;
+                    out["color"]       = nb::make_tuple(color[0], color[1], color[2], color[3]);
+                }
+                out["hash"] = image.hash;
+                out["data"] = toFrame(std::move(image.data), format);
+                return out;
+            },
+            R"pbdoc(
+                Render the map with information to deduplicate the output.
+
+                Images of a single color, such as empty ocean or land tiles, are
+                detected without unpremultiplying or encoding every pixel; as
+                PNG they are encoded with a single color palette, which is much
+                smaller, and cached for later images of the same size and color.
+
+                Parameters
+                ----------
+                format : str, optional (default: "png")
+                    "png" to return PNG bytes, or "buffer" to return a numpy
+                    array of uint8 pixel values as for renderBuffer().
+
+                Returns
+                -------
+                dict
+                    "data": PNG bytes or numpy array, "uniform": True if every
+                    pixel is the same color, "color": (r, g, b, a) of that color
+                    or None, and "hash": XXH64 hash of the PNG bytes or pixels as
+                    an int.
+            )pbdoc",
+            nb::arg("format") = "png")
+        .def(
+            "renderAtRatios",
+            [](Map &self, const std::vector<float> &ratios, const std::string &format) {
+                std::vector<std::string> frames;
+                {
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    frames = self.renderAtRatios(ratios, format);
+                }
+
+                nb::list out;
+                for (auto &frame : frames) {
+                    out.append(toFrame(std::move(frame), format));
+                }
+                return out;
+            },
+            R"pbdoc(
+                Render a frame of the current camera at each pixel ratio, in
+                order, e.g., to render @1x, @2x, and @3x images from one map.
+
+                The map is changed to each other ratio as for setPixelRatio(), and
+                the pixel ratio of the map is restored afterwards.  Frames at the
+                current ratio are rendered without recreating the renderer, which
+                is kept and restored with its tiles.
+
+                Parameters
+                ----------
+                ratios : list of float
+                    pixel ratios greater than 0 and no greater than 8
+                format : str, optional (default: "png")
+                    "png" to return PNG bytes, or "buffer" to return numpy
+                    arrays of uint8 pixel values as for renderBuffer().
+
+                Returns
+                -------
+                list
+                    one frame for each ratio, in order.
+            )pbdoc",
+            nb::arg("ratios"),
+            nb::arg("format") = "png")
+        .def(
+            "renderRegion",
+            [](Map &self,
+               uint32_t x,
+               uint32_t y,
+               uint32_t width,
+               uint32_t height,
+               const std::string &format) {
+                std::string frame;
+                {
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    frame = self.renderRegion(x, y, width, height, format);
+                }
+                return toFrame(std::move(frame), format);
+            },
+            R"pbdoc(
+                Render only a window of the map at its current size and camera.
+
+                The map is rendered at the size of the window, centered on it,
+                instead of rendering the whole map and cropping, so that only
+                the pixels of the window are drawn and read back.  Labels near
+                the edges of the window may be placed differently than in a
+                full render.  Pitch must be 0.
+
+                Parameters
+                ----------
+                x : int
+                    left edge of the window, in pixels from the left of the map
+                y : int
+                    top edge of the window, in pixels from the top of the map
+                width : int
+                    width of the window
+                height : int
+                    height of the window
+                format : str, optional (default: "png")
+                    "png" to return PNG bytes, or "buffer" to return a numpy
+                    array of uint8 pixel values as for renderBuffer().
+
+                Returns
+                -------
+                bytes or numpy array
+            )pbdoc",
+            nb::arg("x"),
+            nb::arg("y"),
+            nb::arg("width"),
+            nb::arg("height"),
+            nb::arg("format") = "png")
+        .def(
+            "renderTiledPNG",
+            [](Map &self,
+               const std::string &filename,
+               uint32_t width,
+               uint32_t height,
+               uint32_t tileSize,
+               uint32_t overlap) {
+                // release the GIL while rendering
+                nb::gil_scoped_release release;
+                self.renderTiledPNG(filename, width, height, tileSize, overlap);
+            },
+            R"pbdoc(
+                Render an image larger than the map, centered on the current
+                camera, to a PNG file.
+
+                The image is rendered as a grid of tiles one at a time, so it
+                may be larger than the maximum texture size of the GPU.  Rows of
+                tiles are encoded as they are rendered, so only one row of tiles
+                is held in memory.  Bearing and pitch must be 0.
+
+                Parameters
+                ----------
+                filename : str
+                    path of the PNG file to write.
+                width : int
+                    width of the image in pixels, before the pixel ratio of the
+                    map is applied.
+                height : int
+                    height of the image in pixels, before the pixel ratio of the
+                    map is applied.
+                tileSize : int, optional (default: 1024)
+                    width and height of each tile in pixels, before the pixel
+                    ratio of the map is applied.
+                overlap : int, optional (default: 128)
+                    pixels of surrounding map rendered on each side of each tile
+                    and then discarded, so that labels near the edges of tiles are
+                    placed consistently with neighboring tiles.
+            )pbdoc",
+            nb::arg("filename"),
+            nb::arg("width"),
+            nb::arg("height"),
+            nb::arg("tileSize") = 1024,
+            nb::arg("overlap")  = 128)
+        .def(
+            "renderTiles",
+            [](Map &self,
+               nb::iterable tiles,
+               TileWriter &writer,
+               bool skipEmpty,
+               double buffer) {
+                std::vector<TileID> tileIDs;
+                for (nb::handle item : tiles) {
+                    tileIDs.push_back(toTileID(item));
+                }
+
+                // release the GIL while rendering
+                nb::gil_scoped_release release;
+                return self.renderTiles(tileIDs, writer, skipEmpty, buffer);
+            },
+            R"pbdoc(
+                Render tiles as PNG and add them to an MBTiles or PMTiles file.
+
+                The map must be square; its width is the size of each tile, so
+                a 256 x 256 map renders tiles of zoom z at zoom z - 1.  Each tile
+                is encoded and written while the next is rendered, and tiles of
+                a single color share one stored image.  The camera of the map is
+                restored afterwards.
+
+                Parameters
+                ----------
+                tiles : list of tuples
+                    (z, x, y) of each tile in the XYZ scheme.
+                writer : MBTilesWriter or PMTilesWriter
+                    writer to add tiles to; pending tiles are flushed when done.
+                skipEmpty : bool, optional (default: True)
+                    if True, only the first tile of each zoom for which
+                    tileHasData() is False is rendered; if it is a single color,
+                    such as the background, its image is written for the other
+                    such tiles of that zoom.
+                buffer : float, optional (default: 0.25)
+                    buffer passed to tileHasData().
+
+                Returns
+                -------
+                int
+                    number of tiles written.
+            )pbdoc",
+            nb::arg("tiles"),
+            nb::arg("writer"),
+            nb::arg("skipEmpty") = true,
+            nb::arg("buffer")    = 0.25)
+        .def(
+            "renderPath",
+            [](Map &self, nb::iterable keyframes, double fps, nb::object output) {
+                std::vector<Keyframe> path;
+                for (nb::handle item : keyframes) {
+                    path.push_back(toKeyframe(item));
+                }
+
+                // bool is a subclass of int, but True is not meant as stdout
+                if (nb::isinstance<nb::int_>(output) && !nb::isinstance<nb::bool_>(output)) {
+                    const int fd = nb::cast<int>(output);
+
+                    // release the GIL while rendering
+                    nb::gil_scoped_release release;
+                    return self.renderPath(path, fps, fd);
+                }
+
+                if (!nb::isinstance<nb::callable>(output)) {
+                    throw nb::type_error("output must be a file descriptor or callable");
+                }
+
+                // frames are passed to the callback on a separate thread,
+                // which must acquire the GIL to call it
+                nb::callable callback = nb::borrow<nb::callable>(output);
+                FrameCallback onFrame = [&callback](const uint8_t *data, size_t size) {
+                    nb::gil_scoped_acquire acquire;
+                    callback(nb::bytes(reinterpret_cast<const char *>(data), size));
+                };
+
+                nb::gil_scoped_release release;
+                return self.renderPath(path, fps, onFrame);
+            },
+            R"pbdoc(
+                Render frames along a camera path interpolated between keyframes.
+
+                Frames are rendered at fps from the time of the first keyframe
+                to the time of the last, including both.  Each frame is written
+                as RGBA pixels (width * height * 4 bytes) to output while the
+                next frame is rendered.  The camera of the map is restored
+                afterwards.
+
+                Parameters
+                ----------
+                keyframes : list of tuples
+                    Each tuple is (time, longitude, latitude, zoom) with optional
+                    bearing and pitch, followed by an optional easing of the
+                    transition from the previous keyframe: "linear" (default),
+                    "ease", "ease-in", "ease-out", or "ease-in-out".  Time is in
+                    seconds and keyframes must be in order of time.  Longitude and
+                    bearing change in the shortest direction, so a path may cross
+                    the antimeridian.
+                fps : float
+                    frames per second.
+                output : int or callable
+                    file descriptor to write frames to, e.g., the stdin of a
+                    video encoder subprocess, or a function called with the
+                    bytes of each frame, in order.
+
+                Returns
+                -------
+                int
+                    number of frames rendered.
+            )pbdoc",
+            nb::arg("keyframes"),
+            nb::arg("fps"),
+            nb::arg("output"))
         .def("setBearing",
              &Map::setBearing,
              R"pbdoc(
@@ -439,6 +1480,26 @@ NB_MODULE(_pymgl, m) {
             )pbdoc",
              nb::arg("layerID"),
              nb::arg("visible"))
+        .def("setStyle",
+             &Map::setStyle,
+             R"pbdoc(
+                Set the style of the map.
+
+                By default, only the sources and layers that differ from the
+                current style are replaced, which keeps loaded tiles for
+                unchanged sources.  The whole style is reloaded if other
+                top-level properties (e.g., sprite or glyphs) differ or if the
+                order of unchanged layers differs.
+
+                Parameters
+                ----------
+                style : str
+                    Mapbox GL / Maplibre GL style object as json-encoded string.
+                diff : bool, optional (default: True)
+                    If False, always reload the whole style.
+            )pbdoc",
+             nb::arg("style"),
+             nb::arg("diff") = true)
         .def("setPitch",
              &Map::setPitch,
              R"pbdoc(
@@ -472,5 +1533,47 @@ NB_MODULE(_pymgl, m) {
                 height : int
             )pbdoc",
              nb::arg("width"),
-             nb::arg("height"));
+             nb::arg("height"))
+        .def(
+            "setPixelRatio",
+            [](Map &self, float ratio) {
+                // release the GIL while recreating the renderer
+                nb::gil_scoped_release release;
+                self.setPixelRatio(ratio);
+            },
+            R"pbdoc(
+                Set the pixel ratio of rendered images.
+
+                The renderer and style are recreated at the new ratio.  Sources,
+                layers, and images added to the map are kept, including changes
+                made to them, but feature state is cleared.  Tiles are parsed
+                again and sprites are loaded at the new ratio the next time the
+                map is rendered.
+
+                Parameters
+                ----------
+                ratio : float
+                    pixel ratio greater than 0
+            )pbdoc",
+            nb::arg("ratio"))
+        .def(
+            "trim",
+            [](Map &self, bool aggressive) {
+                nb::gil_scoped_release release;
+                self.trim(aggressive);
+            },
+            R"pbdoc(
+                Release memory held by the renderer without destroying the map.
+
+                Tiles and GPU resources that are not in use are released.  GPU
+                resources are freed during the next render, so memoryUsage()
+                reflects the release only after rendering again.
+
+                Parameters
+                ----------
+                aggressive : bool, optional (default: False)
+                    if True, release all tiles; these are reloaded when the map
+                    is next rendered.
+            )pbdoc",
+            nb::arg("aggressive") = false);
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include <stdexcept>
+
+#include <mbgl/util/platform.hpp>
+
+#include "frame_pipeline.h"
+
+namespace mgl_wrapper {
+
+FramePipeline::FramePipeline(Process process, size_t depth)
+    : process(std::move(process)), depth(depth) {
+    if (depth == 0) {
+        throw std::domain_error("depth must be greater than 0");
+    }
+    worker = std::thread([this]() { run(); });
+}
+
+FramePipeline::~FramePipeline() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        queue.clear();
+    }
+    changed.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void FramePipeline::push(mbgl::PremultipliedImage image) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return queue.size() < depth || error; });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        queue.emplace_back(next++, std::move(image));
+    }
+    changed.notify_all();
+}
+
+void FramePipeline::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    changed.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void FramePipeline::run() {
+    mbgl::platform::setCurrentThreadName("FramePipeline");
+
+    while (true) {
+        std::pair<uint64_t, mbgl::PremultipliedImage> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return !queue.empty() || done; });
+            if (queue.empty()) {
+                return;
+            }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        changed.notify_all();
+
+        try {
+            process(frame.first, std::move(frame.second));
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+                queue.clear();
+            }
+            changed.notify_all();
+            return;
+        }
+    }
+}
+
+} // namespace mgl_wrapper
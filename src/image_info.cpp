@@ -0,0 +1,177 @@
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "image_info.h"
+#include "spng.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t prime3 = 0x165667B19E3779F9ULL;
+const uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+// unaligned little endian reads; all supported platforms are little endian
+inline uint64_t read64(const uint8_t *data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint32_t read32(const uint8_t *data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint64_t hashRound(uint64_t acc, uint64_t input) {
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= hashRound(0, value);
+    return acc * prime1 + prime4;
+}
+
+} // namespace
+
+std::optional<Color> uniformColor(const uint8_t *data, size_t pixels) {
+    if (pixels == 0) {
+        return std::nullopt;
+    }
+
+    const uint32_t first   = read32(data);
+    const uint64_t pattern = (uint64_t(first) << 32) | first;
+
+    // compare blocks of 8 pixels without branching within a block, so that
+    // the comparison is vectorized by the compiler
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        const uint8_t *block = data + i * 4;
+        const uint64_t diff  = (read64(block) ^ pattern) | (read64(block + 8) ^ pattern)
+                            | (read64(block + 16) ^ pattern) | (read64(block + 24) ^ pattern);
+        if (diff != 0) {
+            return std::nullopt;
+        }
+    }
+    for (; i < pixels; i++) {
+        if (read32(data + i * 4) != first) {
+            return std::nullopt;
+        }
+    }
+
+    return Color{data[0], data[1], data[2], data[3]};
+}
+
+uint64_t xxhash64(const uint8_t *data, size_t size, uint64_t seed) {
+    const uint8_t *end = data + size;
+    uint64_t hash;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+
+        const uint8_t *limit = end - 32;
+        do {
+            v1 = hashRound(v1, read64(data));
+            v2 = hashRound(v2, read64(data + 8));
+            v3 = hashRound(v3, read64(data + 16));
+            v4 = hashRound(v4, read64(data + 24));
+            data += 32;
+        } while (data <= limit);
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + prime5;
+    }
+
+    hash += size;
+
+    for (; data + 8 <= end; data += 8) {
+        hash ^= hashRound(0, read64(data));
+        hash = rotl(hash, 27) * prime1 + prime4;
+    }
+    if (data + 4 <= end) {
+        hash ^= uint64_t(read32(data)) * prime1;
+        hash = rotl(hash, 23) * prime2 + prime3;
+        data += 4;
+    }
+    for (; data < end; data++) {
+        hash ^= *data * prime5;
+        hash = rotl(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::string encodeUniformPNG(uint32_t width, uint32_t height, const Color &color) {
+    struct spng_ihdr ihdr = {0};
+    ihdr.width            = width;
+    ihdr.height           = height;
+    ihdr.bit_depth        = 1;
+    ihdr.color_type       = SPNG_COLOR_TYPE_INDEXED;
+
+    struct spng_plte plte = {0};
+    plte.n_entries        = 1;
+    plte.entries[0].red   = color[0];
+    plte.entries[0].green = color[1];
+    plte.entries[0].blue  = color[2];
+
+    struct spng_trns trns = {0};
+    trns.n_type3_entries  = 1;
+    trns.type3_alpha[0]   = color[3];
+
+    // every pixel is index 0 of the palette; rows are packed 8 pixels per byte
+    const std::vector<uint8_t> rows(size_t((width + 7) / 8) * height, 0);
+
+    spng_ctx *ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    spng_set_ihdr(ctx, &ihdr);
+    spng_set_plte(ctx, &plte);
+    if (color[3] != 255) {
+        spng_set_trns(ctx, &trns);
+    }
+
+    int ret = spng_encode_image(ctx, rows.data(), rows.size(), SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+    if (ret) {
+        spng_ctx_free(ctx);
+        throw std::runtime_error("could not encode image, error: "
+                                 + std::string(spng_strerror(ret)));
+    }
+
+    size_t size;
+    auto buf = static_cast<unsigned char *>(spng_get_png_buffer(ctx, &size, &ret));
+    if (buf == NULL) {
+        spng_ctx_free(ctx);
+        throw std::runtime_error("could not get encoded image, error: "
+                                 + std::string(spng_strerror(ret)));
+    }
+
+    std::string out(buf, buf + size);
+
+    free(buf);
+    spng_ctx_free(ctx);
+
+    return out;
+}
+
+} // namespace mgl_wrapper
@@ -1,11 +1,22 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <zlib.h>
 
+#include <mbgl/gfx/context.hpp>
+#include <mbgl/gfx/renderer_backend.hpp>
 #include <mbgl/map/map_observer.hpp>
 #include <mbgl/map/map_options.hpp>
 #include <mbgl/renderer/renderer.hpp>
@@ -14,22 +25,30 @@
 #include <mbgl/style/conversion/layer.hpp>
 #include <mbgl/style/conversion/source.hpp>
 #include <mbgl/style/conversion/tileset.hpp>
+#include <mbgl/style/image.hpp>
 #include <mbgl/style/layers/background_layer.hpp>
 #include <mbgl/style/sources/geojson_source.hpp>
 #include <mbgl/style/sources/vector_source.hpp>
 #include <mbgl/style/style.hpp>
 #include <mbgl/util/color.hpp>
+#include <mbgl/util/constants.hpp>
 #include <mbgl/util/geojson.hpp>
 #include <mbgl/util/image.hpp>
 #include <mbgl/util/mapbox.hpp>
 #include <mbgl/util/premultiply.hpp>
+#include <mbgl/util/projection.hpp>
 #include <mbgl/util/range.hpp>
+#include <mbgl/util/unitbezier.hpp>
 
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include "frame_pipeline.h"
+#include "image_info.h"
 #include "map.h"
+#include "png_writer.h"
+#include "shared_frame.h"
 #include "spng.h"
 
 namespace mgl_wrapper {
@@ -63,6 +82,118 @@ void writeJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer> &writer,
                 });
 }
 
+// encode an unpremultiplied image to PNG bytes
+std::string encodePNG(const mbgl::UnassociatedImage &image) {
+    struct spng_ihdr ihdr = {0};
+    ihdr.width            = image.size.width;
+    ihdr.height           = image.size.height;
+    ihdr.bit_depth        = 8;
+    ihdr.color_type       = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;
+
+    spng_ctx *ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    spng_set_ihdr(ctx, &ihdr);
+    spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    spng_set_option(ctx, SPNG_FILTER_CHOICE, SPNG_FILTER_CHOICE_NONE);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, 3);
+
+    int ret = spng_encode_image(ctx,
+                                static_cast<const void *>(image.data.get()),
+                                image.bytes(),
+                                SPNG_FMT_PNG,
+                                SPNG_ENCODE_FINALIZE);
+
+    if (ret) {
+        spng_ctx_free(ctx);
+        throw std::runtime_error("could not encode image, error: "
+                                 + std::string(spng_strerror(ret)));
+    }
+
+    size_t png_size;
+    auto buf = static_cast<unsigned char *>(spng_get_png_buffer(ctx, &png_size, &ret));
+
+    if (buf == NULL) {
+        spng_ctx_free(ctx);
+        throw std::runtime_error("could not get encoded image, error: "
+                                 + std::string(spng_strerror(ret)));
+    }
+
+    std::string out = std::string(buf, buf + png_size);
+
+    free(buf);
+    spng_ctx_free(ctx);
+
+    return out;
+}
+
+// Open a file for writing, replacing it if it exists
+int openForWrite(const std::string &filename) {
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("could not open " + filename + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+// Return the eased progress of a transition at t between 0 and 1, using the
+// same curves as CSS easing functions
+double ease(const std::string &easing, double t) {
+    if (easing == "linear") {
+        return t;
+    }
+    if (easing == "ease") {
+        return mbgl::util::UnitBezier(0.25, 0.1, 0.25, 1).solve(t, 1e-6);
+    }
+    if (easing == "ease-in") {
+        return mbgl::util::UnitBezier(0.42, 0, 1, 1).solve(t, 1e-6);
+    }
+    if (easing == "ease-out") {
+        return mbgl::util::UnitBezier(0, 0, 0.58, 1).solve(t, 1e-6);
+    }
+    if (easing == "ease-in-out") {
+        return mbgl::util::UnitBezier(0.42, 0, 0.58, 1).solve(t, 1e-6);
+    }
+    throw std::invalid_argument("easing must be one of: linear, ease, ease-in, ease-out, "
+                                "ease-in-out");
+}
+
+Camera interpolateCamera(const std::vector<Keyframe> &keyframes, double time) {
+    if (keyframes.empty()) {
+        throw std::invalid_argument("keyframes must not be empty");
+    }
+    if (time <= keyframes.front().time) {
+        return keyframes.front().camera;
+    }
+    if (time >= keyframes.back().time) {
+        return keyframes.back().camera;
+    }
+
+    // find the keyframe at or after time
+    auto next = std::lower_bound(
+        keyframes.begin(), keyframes.end(), time, [](const Keyframe &keyframe, double t) {
+            return keyframe.time < t;
+        });
+    const Keyframe &to   = *next;
+    const Keyframe &from = *(next - 1);
+
+    const double t = ease(to.easing, (time - from.time) / (to.time - from.time));
+    auto lerp      = [t](double a, double b) { return a + (b - a) * t; };
+
+    // rotate in the shortest direction
+    const double delta   = std::fmod(to.camera.bearing - from.camera.bearing + 540, 360) - 180;
+    const double bearing = std::fmod(from.camera.bearing + delta * t + 360, 360);
+
+    // move in the shortest direction, across the antimeridian if it is closer
+    const double lonDelta
+        = std::fmod(to.camera.longitude - from.camera.longitude + 540, 360) - 180;
+    const double longitude = std::fmod(from.camera.longitude + lonDelta * t + 540, 360) - 180;
+
+    return Camera{longitude,
+                  lerp(from.camera.latitude, to.camera.latitude),
+                  lerp(from.camera.zoom, to.camera.zoom),
+                  bearing,
+                  lerp(from.camera.pitch, to.camera.pitch)};
+}
+
 Map::Map(const std::string &style,
          const std::optional<uint32_t> &width,
          const std::optional<uint32_t> &height,
@@ -73,11 +204,83 @@ Map::Map(const std::string &style,
          const std::optional<std::string> &token,
          const std::optional<std::string> &provider) {
 
+    TraceSpan span("Map", "map");
+
+    init(width, height, ratio, zoom, token, provider);
+    ResourceAccounting::Scope accountingScope(accounting);
+
+    Timer styleTimer;
+    TraceSpan styleSpan("loadStyle", "style");
+    if (style.find("{") == 0) {
+        // assume content is json
+        loadStyleJSON(style);
+    } else if (style.find("://") != -1) {
+        // otherwise must be URL-like reference, like "mapbox://styles/mapbox/streets-v11"
+        // if local, must be an absolute path: file://<absolute_path>
+        map->getStyle().loadURL(style);
+    } else if (style.empty()) {
+        // construct blank JSON
+        map->getStyle().loadJSON(R"({
+            "version": 8,
+            "name": "test style",
+            "sources": {},
+            "layers": []
+        })");
+    } else {
+        throw std::invalid_argument("style is not valid");
+    }
+    currentPhases.styleLoad += styleTimer.elapsed();
+
+    jumpToInitialCamera(longitude, latitude, zoom);
+}
+
+Map::Map(const std::shared_ptr<StyleTemplate> &style,
+         const std::optional<uint32_t> &width,
+         const std::optional<uint32_t> &height,
+         const std::optional<float> &ratio,
+         const std::optional<double> &longitude,
+         const std::optional<double> &latitude,
+         const std::optional<double> &zoom,
+         const std::optional<std::string> &token,
+         const std::optional<std::string> &provider) {
+
+    if (!style) {
+        throw std::invalid_argument("style template must not be None");
+    }
+
+    TraceSpan span("Map", "map");
+
+    // the template is loaded in place of the blank style, so the map's style
+    // is only loaded once
+    init(width, height, ratio, zoom, token, provider);
+    ResourceAccounting::Scope accountingScope(accounting);
+
+    Timer styleTimer;
+    TraceSpan styleSpan("instantiateStyleTemplate", "style");
+    style->instantiate(map->getStyle());
+    accounting->addStyle(style->getJSON());
+    currentPhases.styleLoad += styleTimer.elapsed();
+
+    // the map's style only has the template's top-level properties; keep the
+    // full JSON so that later style diffs compare against the template
+    currentStyleJSON = style->getJSON();
+
+    jumpToInitialCamera(longitude, latitude, zoom);
+}
+
+void Map::init(const std::optional<uint32_t> &width,
+               const std::optional<uint32_t> &height,
+               const std::optional<float> &ratio,
+               const std::optional<double> &zoom,
+               const std::optional<std::string> &token,
+               const std::optional<std::string> &provider) {
+
     // loop must be created before frontend
-    loop     = std::make_unique<mbgl::util::RunLoop>();
-    frontend = std::make_unique<mbgl::HeadlessFrontend>(
-        mbgl::Size{width.value_or(256), height.value_or(256)}, ratio.value_or(1));
-    observer = std::make_unique<MapObserver>();
+    loop       = std::make_unique<mbgl::util::RunLoop>();
+    pixelRatio = ratio.value_or(1);
+    frontend   = std::make_unique<mbgl::HeadlessFrontend>(
+        mbgl::Size{width.value_or(256), height.value_or(256)}, pixelRatio);
+    observer   = std::make_unique<MapObserver>();
 
     // determine tile server options from provider
     mbgl::TileServerOptions tileServerOptions = mbgl::TileServerOptions();
@@ -119,6 +322,11 @@ Map::Map(const std::string &style,
         resourceOptions.withApiKey(token.value());
     }
 
+    // count resources loaded by this map; requests are attributed to it
+    // while it is loading its style or rendering
+    ResourceAccounting::install();
+    accounting = std::make_shared<ResourceAccounting>();
+
     map = std::make_unique<mbgl::Map>(*frontend,
                                       *observer,
                                       mbgl::MapOptions()
@@ -126,31 +334,11 @@ Map::Map(const std::string &style,
                                           .withSize(frontend->getSize())
                                           .withPixelRatio(ratio.value_or(1)),
                                       resourceOptions.withTileServerOptions(tileServerOptions));
+}
 
-    if (style.find("{") == 0) {
-        observer->didFailLoadingMapCallback
-            = [&](mbgl::MapLoadError type, const std::string &description) {
-                  throw std::runtime_error(description);
-              };
-
-        // assume content is json
-        map->getStyle().loadJSON(style);
-    } else if (style.find("://") != -1) {
-        // otherwise must be URL-like reference, like "mapbox://styles/mapbox/streets-v11"
-        // if local, must be an absolute path: file://<absolute_path>
-        map->getStyle().loadURL(style);
-    } else if (style.empty()) {
-        // construct blank JSON
-        map->getStyle().loadJSON(R"({
-            "version": 8,
-            "name": "test style",
-            "sources": {},
-            "layers": []
-        })");
-    } else {
-        throw std::invalid_argument("style is not valid");
-    }
-
+void Map::jumpToInitialCamera(const std::optional<double> &longitude,
+                              const std::optional<double> &latitude,
+                              const std::optional<double> &zoom) {
     map->jumpTo(mbgl::CameraOptions()
                     .withCenter(mbgl::LatLng{latitude.value_or(0), longitude.value_or(0)})
                     .withZoom(zoom.value_or(0))
@@ -186,12 +374,18 @@ void Map::addImage(const std::string &name,
 
     map->getStyle().addImage(std::make_unique<mbgl::style::Image>(
         name, std::move(cPremultipliedImage), ratio, make_sdf));
+    imageBytes[name] = image.length();
 }
 
 void Map::addSource(const std::string &id, const std::string &options) {
     using namespace mbgl::style;
     using namespace mbgl::style::conversion;
 
+    if (pendingOperations) {
+        pendingOperations->push_back({"addSource", {id, options}});
+        return;
+    }
+
     Error error;
     std::optional<std::unique_ptr<Source>> source
         = convertJSON<std::unique_ptr<Source>>(options, error, id);
@@ -201,12 +395,18 @@ void Map::addSource(const std::string &id, const std::string &options) {
     }
 
     map->getStyle().addSource(std::move(*source));
+    accounting->addSource(id, options);
 }
 
 void Map::addLayer(const std::string &options) {
     using namespace mbgl::style;
     using namespace mbgl::style::conversion;
 
+    if (pendingOperations) {
+        pendingOperations->push_back({"addLayer", {options}});
+        return;
+    }
+
     Error error;
     std::optional<std::unique_ptr<Layer>> layer
         = convertJSON<std::unique_ptr<Layer>>(options, error);
@@ -218,6 +418,177 @@ void Map::addLayer(const std::string &options) {
     map->getStyle().addLayer(std::move(*layer));
 }
 
+void Map::beginBatch() {
+    if (pendingOperations) {
+        throw std::runtime_error("a batch is already in progress");
+    }
+    pendingOperations = std::vector<StyleOperation>();
+}
+
+void Map::commitBatch() {
+    if (!pendingOperations) {
+        throw std::runtime_error("no batch is in progress");
+    }
+
+    // the batch is closed even if any of its operations are invalid
+    std::vector<StyleOperation> operations = std::move(*pendingOperations);
+    pendingOperations.reset();
+
+    applyStyleOperations(operations);
+}
+
+void Map::discardBatch() { pendingOperations.reset(); }
+
+const bool Map::isBatching() { return pendingOperations.has_value(); }
+
+void Map::applyStyleOperations(const std::vector<StyleOperation> &operations) {
+    using namespace mbgl::style;
+    using namespace mbgl::style::conversion;
+
+    auto &style = map->getStyle();
+
+    // layers and sources added earlier in this set of operations, so that
+    // later operations may refer to them
+    std::unordered_map<std::string, const Layer *> addedLayers;
+    std::unordered_set<std::string> addedSources;
+
+    auto findLayer = [&](const std::string &layerID) -> const Layer * {
+        auto added = addedLayers.find(layerID);
+        if (added != addedLayers.end()) {
+            return added->second;
+        }
+        const Layer *layer = style.getLayer(layerID);
+        if (layer == nullptr) {
+            throw std::runtime_error(layerID + " is not a valid layer id in map");
+        }
+        return layer;
+    };
+
+    // Validate and convert all operations before applying any of them, so that
+    // an invalid operation leaves the style unchanged.
+    std::vector<std::function<void()>> updates;
+    updates.reserve(operations.size());
+
+    for (const auto &operation : operations) {
+        const std::string &type = operation.type;
+        const auto &args        = operation.args;
+
+        auto expectArgs = [&](size_t count) {
+            if (args.size() != count) {
+                throw std::invalid_argument(type + " expects " + std::to_string(count)
+                                            + " arguments");
+            }
+        };
+
+        if (type == "addSource") {
+            expectArgs(2);
+            const std::string &id = args[0];
+            if (style.getSource(id) != nullptr || addedSources.count(id)) {
+                throw std::runtime_error("Source " + id + " already exists");
+            }
+
+            Error error;
+            auto source = convertJSON<std::unique_ptr<Source>>(args[1], error, id);
+            if (!source.has_value()) {
+                throw std::invalid_argument(error.message.c_str());
+            }
+            addedSources.insert(id);
+
+            auto holder = std::make_shared<std::unique_ptr<Source>>(std::move(*source));
+            updates.push_back([&style, holder, this, id, options = args[1]]() {
+                style.addSource(std::move(*holder));
+                accounting->addSource(id, options);
+            });
+
+        } else if (type == "addLayer") {
+            expectArgs(1);
+            Error error;
+            auto layer = convertJSON<std::unique_ptr<Layer>>(args[0], error);
+            if (!layer.has_value()) {
+                throw std::invalid_argument(error.message.c_str());
+            }
+
+            const std::string id = (*layer)->getID();
+            if (style.getLayer(id) != nullptr || addedLayers.count(id)) {
+                throw std::runtime_error("Layer " + id + " already exists");
+            }
+            addedLayers[id] = layer->get();
+
+            auto holder = std::make_shared<std::unique_ptr<Layer>>(std::move(*layer));
+            updates.push_back([&style, holder]() { style.addLayer(std::move(*holder)); });
+
+        } else if (type == "setFilter") {
+            expectArgs(2);
+            const std::string layerID = args[0];
+            findLayer(layerID);
+
+            Filter filter;
+            if (!args[1].empty()) {
+                Error error;
+                auto converted = convertJSON<Filter>(args[1], error);
+                if (!converted.has_value()) {
+                    throw std::invalid_argument("invalid filter for " + layerID + ": "
+                                                + error.message);
+                }
+                filter = std::move(*converted);
+            }
+
+            updates.push_back([&style, layerID, filter]() {
+                style.getLayer(layerID)->setFilter(filter);
+            });
+
+        } else if (type == "setPaintProperty") {
+            expectArgs(3);
+            const std::string layerID  = args[0];
+            const std::string property = args[1];
+            const Layer *layer         = findLayer(layerID);
+
+            auto d = std::make_shared<mbgl::JSDocument>();
+            d->Parse<0>(args[2].c_str(), args[2].length());
+            if (d->HasParseError()) {
+                throw std::runtime_error("error parsing paint property: "
+                                         + mbgl::formatJSONParseError(*d));
+            }
+
+            // check the value against a detached copy of the layer, which
+            // shares its properties until modified
+            const mbgl::JSValue *propertyValue = d.get();
+            auto error = layer->cloneRef(layerID)->setProperty(property, propertyValue);
+            if (error) {
+                throw std::runtime_error("invalid value for " + property + ": "
+                                         + error->message);
+            }
+
+            updates.push_back([&style, layerID, property, d]() {
+                const mbgl::JSValue *propertyValue = d.get();
+                style.getLayer(layerID)->setProperty(property, propertyValue);
+            });
+
+        } else if (type == "setVisibility") {
+            expectArgs(2);
+            const std::string layerID = args[0];
+            findLayer(layerID);
+
+            if (args[1] != "true" && args[1] != "false") {
+                throw std::invalid_argument("visibility must be true or false");
+            }
+            const auto visibility
+                = args[1] == "true" ? VisibilityType::Visible : VisibilityType::None;
+
+            updates.push_back([&style, layerID, visibility]() {
+                style.getLayer(layerID)->setVisibility(visibility);
+            });
+
+        } else {
+            throw std::invalid_argument("unsupported style operation: " + type);
+        }
+    }
+
+    for (auto &update : updates) {
+        update();
+    }
+}
+
 const double Map::getBearing() { return std::abs(map->getCameraOptions().bearing.value_or(0)); }
 
 const std::pair<double, double> Map::getCenter() {
@@ -323,10 +694,25 @@ const bool Map::getVisibility(const std::string &layerID) {
 
 const double Map::getPitch() { return map->getCameraOptions().pitch.value_or(0); }
 
+const float Map::getPixelRatio() { return pixelRatio; }
+
 const std::pair<uint32_t, uint32_t> Map::getSize() {
     return std::pair<uint32_t, uint32_t>(frontend->getSize().width, frontend->getSize().height);
 }
 
+const std::vector<std::pair<std::string, SourceStats>> Map::getSourceStats() {
+    return accounting->getSourceStats(listSources());
+}
+
+const std::optional<Bounds> Map::getSourceBounds(const std::string &sourceID) {
+    if (map->getStyle().getSource(sourceID) == nullptr) {
+        throw std::runtime_error(sourceID + " is not a valid source in map");
+    }
+    return accounting->getCoverage().getBounds(sourceID);
+}
+
+const RenderStats Map::getStats() { return stats; }
+
 const double Map::getZoom() { return map->getCameraOptions().zoom.value_or(0); }
 
 void Map::setBearing(const double &bearing) {
@@ -373,12 +759,90 @@ const std::vector<std::string> Map::listSources() {
 }
 
 void Map::load() {
+    ResourceAccounting::Scope accountingScope(accounting);
     if (!map->isFullyLoaded()) {
-        frontend->render(*map);
+        renderingStats = frontend->render(*map).stats;
     } else {
     }
 }
 
+const MemoryUsage Map::memoryUsage() {
+    MemoryUsage usage;
+    usage.textures = std::max<int64_t>(renderingStats.memTextures, 0);
+    usage.buffers  = std::max<int64_t>(renderingStats.memBuffers, 0);
+    for (const auto &entry : imageBytes) {
+        usage.images += entry.second;
+    }
+    usage.geoJSON = accounting->getGeoJSONBytes(listSources());
+
+    usage.textureCount     = std::max(renderingStats.numActiveTextures, 0);
+    usage.bufferCount      = std::max(renderingStats.numBuffers, 0);
+    usage.framebufferCount = std::max(renderingStats.numFrameBuffers, 0);
+    return usage;
+}
+
+const std::vector<std::pair<std::string, double>> Map::profileLayers(uint32_t iterations) {
+    using namespace mbgl::style;
+
+    if (iterations == 0) {
+        throw std::domain_error("iterations must be greater than 0");
+    }
+    if (pendingOperations) {
+        throw std::runtime_error("cannot profile layers while a batch is in progress");
+    }
+
+    TraceSpan span("profileLayers", "render");
+
+    // profiling renders are not included in render stats
+    const RenderPhases phases = currentPhases;
+
+    // Layers are drawn by maplibre-native without any per-layer hooks, and
+    // the headless backend does not expose GPU timer queries, so the cost of
+    // each layer is measured as the difference in the time of a whole render
+    // when it is hidden.  Reading back a frame waits for the GPU to finish
+    // drawing it, so this includes GPU time.
+    auto frameTime = [&]() {
+        std::vector<double> times;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Timer timer;
+            renderStill();
+            times.push_back(timer.elapsed());
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    };
+
+    // load all resources before timing any frames
+    renderStill();
+    const double baseline = frameTime();
+
+    std::vector<std::pair<std::string, double>> layerTimes;
+    for (const auto &layerID : listLayers()) {
+        Layer *layer = map->getStyle().getLayer(layerID);
+        if (layer->getVisibility() != VisibilityType::Visible) {
+            layerTimes.emplace_back(layerID, 0);
+            continue;
+        }
+
+        layer->setVisibility(VisibilityType::None);
+        double time;
+        try {
+            time = frameTime();
+        } catch (...) {
+            layer->setVisibility(VisibilityType::Visible);
+            currentPhases = phases;
+            throw;
+        }
+        layer->setVisibility(VisibilityType::Visible);
+
+        layerTimes.emplace_back(layerID, std::max(baseline - time, 0.0));
+    }
+
+    currentPhases = phases;
+
+    return layerTimes;
+}
+
 void Map::removeFeatureState(const std::string &sourceID,
                              const std::string &layerID,
                              const std::string &featureID,
@@ -423,7 +887,11 @@ void Map::setGeoJSON(const std::string &sourceID, const std::string &geoJSON) {
         throw std::runtime_error(sourceID + " is not a GeoJSON source");
     }
 
-    source->setGeoJSON(mapbox::geojson::parse(geoJSON));
+    // bounds of the data are read from the parsed data rather than parsing
+    // the JSON again
+    const mapbox::geojson::geojson data = mapbox::geojson::parse(geoJSON);
+    source->setGeoJSON(data);
+    accounting->setGeoJSON(sourceID, data, geoJSON.size());
 }
 
 void Map::setFeatureState(const std::string &sourceID,
@@ -500,6 +968,11 @@ void Map::setFilter(const std::string &layerID, const std::optional<std::string>
     using namespace mbgl::style;
     using namespace mbgl::style::conversion;
 
+    if (pendingOperations) {
+        pendingOperations->push_back({"setFilter", {layerID, expression.value_or("")}});
+        return;
+    }
+
     auto layer = map->getStyle().getLayer(layerID);
     if (layer == nullptr) {
         throw std::runtime_error(layerID + " is not a valid layer id in map");
@@ -520,6 +993,11 @@ void Map::setPaintProperty(const std::string &layerID,
 
     using namespace mbgl::style::conversion;
 
+    if (pendingOperations) {
+        pendingOperations->push_back({"setPaintProperty", {layerID, property, value}});
+        return;
+    }
+
     auto layer = map->getStyle().getLayer(layerID);
     if (layer == nullptr) {
         throw std::runtime_error(layerID + " is not a valid layer id in map");
@@ -536,6 +1014,11 @@ void Map::setPaintProperty(const std::string &layerID,
 }
 
 void Map::setVisibility(const std::string &layerID, bool visible) {
+    if (pendingOperations) {
+        pendingOperations->push_back({"setVisibility", {layerID, visible ? "true" : "false"}});
+        return;
+    }
+
     auto layer = map->getStyle().getLayer(layerID);
     if (layer == nullptr) {
         throw std::runtime_error(layerID + " is not a valid layer id in map");
@@ -556,67 +1039,1156 @@ void Map::setSize(const uint32_t &width, const uint32_t &height) {
     map->setSize(mbgl::Size{width, height});
 }
 
-void Map::setZoom(const double &zoom) {
-    validateZoom(zoom);
-    map->jumpTo(mbgl::CameraOptions().withZoom(zoom));
+// IDs of the layers of a style, in order
+std::vector<std::string> layerIDs(mbgl::style::Style &style) {
+    std::vector<std::string> ids;
+    for (const auto *layer : style.getLayers()) {
+        ids.push_back(layer->getID());
+    }
+    return ids;
 }
 
-void Map::render() { frontend->render(*map); }
+// IDs of the sources of a style, in order
+std::vector<std::string> sourceIDs(mbgl::style::Style &style) {
+    std::vector<std::string> ids;
+    for (const auto *source : style.getSources()) {
+        ids.push_back(source->getID());
+    }
+    return ids;
+}
 
-const std::string Map::renderPNG() {
-    // render produces premultiplied image; unpremultiply it
-    auto image = mbgl::util::unpremultiply(frontend->render(*map).image);
+void Map::setPixelRatio(const float &ratio) {
+    validatePixelRatio(ratio);
+    if (ratio == pixelRatio) {
+        return;
+    }
+    if (pendingOperations) {
+        throw std::runtime_error("cannot set pixel ratio while a batch is in progress");
+    }
 
-    struct spng_ihdr ihdr = {0};
-    ihdr.width            = image.size.width;
-    ihdr.height           = image.size.height;
-    ihdr.bit_depth        = 8;
-    ihdr.color_type       = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;
+    TraceSpan span("setPixelRatio", "map", {{"ratio", std::to_string(ratio)}});
+    ResourceAccounting::Scope accountingScope(accounting);
 
-    spng_ctx *ctx = spng_ctx_new(SPNG_CTX_ENCODER);
-    spng_set_ihdr(ctx, &ihdr);
-    spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
-    spng_set_option(ctx, SPNG_FILTER_CHOICE, SPNG_FILTER_CHOICE_NONE);
-    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, 3);
+    // create the new renderer and style before changing the current ones, and
+    // move the current sources and layers back if they cannot all be moved,
+    // so that the map is unchanged if any step fails
+    auto [nextFrontend, nextMap] = createRenderer(ratio);
+    moveStyleContents(*map, *nextMap);
 
-    int ret = spng_encode_image(ctx,
-                                static_cast<const void *>(image.data.get()),
-                                image.bytes(),
-                                SPNG_FMT_PNG,
-                                SPNG_ENCODE_FINALIZE);
+    // the map must be destroyed before its frontend
+    map            = std::move(nextMap);
+    frontend       = std::move(nextFrontend);
+    pixelRatio     = ratio;
+    renderingStats = mbgl::gfx::RenderingStats();
+}
 
-    if (ret) {
-        spng_ctx_free(ctx);
-        throw std::runtime_error("could not encode image, error: "
-                                 + std::string(spng_strerror(ret)));
+std::pair<std::unique_ptr<mbgl::HeadlessFrontend>, std::unique_ptr<mbgl::Map>>
+Map::createRenderer(float ratio) {
+    auto &style            = map->getStyle();
+    const mbgl::Size size  = frontend->getSize();
+    const std::string json = style.getJSON();
+    const std::string url  = style.getURL();
+
+    auto nextFrontend = std::make_unique<mbgl::HeadlessFrontend>(size, ratio);
+    auto nextMap      = std::make_unique<mbgl::Map>(
+        *nextFrontend,
+        *observer,
+        mbgl::MapOptions().withMapMode(mbgl::MapMode::Static).withSize(size).withPixelRatio(ratio),
+        map->getResourceOptions().clone());
+    auto &nextStyle = nextMap->getStyle();
+
+    if (json.empty() && !url.empty()) {
+        // the style has not loaded yet, so it has no sources or layers to move
+        nextStyle.loadURL(url);
+    } else {
+        // the style JSON provides the sprite, glyphs, and other top-level
+        // properties; its sources and layers are replaced by the current ones
+        nextStyle.loadJSON(json);
+        for (const auto &id : layerIDs(nextStyle)) {
+            nextStyle.removeLayer(id);
+        }
+        for (const auto &id : sourceIDs(nextStyle)) {
+            nextStyle.removeSource(id);
+        }
     }
 
-    size_t png_size;
-    auto buf = static_cast<unsigned char *>(spng_get_png_buffer(ctx, &png_size, &ret));
+    nextMap->jumpTo(map->getCameraOptions());
 
-    if (buf == NULL) {
-        spng_ctx_free(ctx);
-        throw std::runtime_error("could not get encoded image, error: "
-                                 + std::string(spng_strerror(ret)));
+    return {std::move(nextFrontend), std::move(nextMap)};
+}
+
+void Map::moveStyleContents(mbgl::Map &from, mbgl::Map &to) {
+    auto &style     = from.getStyle();
+    auto &nextStyle = to.getStyle();
+
+    // sources cannot be removed while layers use them, so remove layers
+    // first and add them back after their sources
+    const auto layers  = layerIDs(style);
+    const auto sources = sourceIDs(style);
+    std::vector<std::unique_ptr<mbgl::style::Layer>> removedLayers;
+    std::vector<std::unique_ptr<mbgl::style::Source>> removedSources;
+    for (const auto &id : layers) {
+        removedLayers.push_back(style.removeLayer(id));
+    }
+    for (const auto &id : sources) {
+        removedSources.push_back(style.removeSource(id));
     }
 
-    std::string out = std::string(buf, buf + png_size);
+    try {
+        for (auto &source : removedSources) {
+            nextStyle.addSource(std::move(source));
+        }
+        for (auto &layer : removedLayers) {
+            nextStyle.addLayer(std::move(layer));
+        }
+    } catch (...) {
+        // take back whatever was added and restore the original order
+        for (size_t i = layers.size(); i-- > 0;) {
+            if (!removedLayers[i]) {
+                removedLayers[i] = nextStyle.removeLayer(layers[i]);
+            }
+        }
+        for (size_t i = sources.size(); i-- > 0;) {
+            if (!removedSources[i]) {
+                removedSources[i] = nextStyle.removeSource(sources[i]);
+            }
+        }
+        for (auto &source : removedSources) {
+            style.addSource(std::move(source));
+        }
+        for (auto &layer : removedLayers) {
+            style.addLayer(std::move(layer));
+        }
+        throw;
+    }
 
-    free(buf);
-    spng_ctx_free(ctx);
+    // only images added to the style are copied; images from the sprite are
+    // loaded at the ratio of the new style
+    for (const auto &[name, bytes] : imageBytes) {
+        auto image = style.getImage(name);
+        if (image) {
+            nextStyle.addImage(std::make_unique<mbgl::style::Image>(
+                name, (*image)->image.clone(), (*image)->pixelRatio, (*image)->sdf));
+        }
+    }
+}
+
+void Map::setStyle(const std::string &style, bool diff) {
+    if (pendingOperations) {
+        throw std::runtime_error("cannot set style while a batch is in progress");
+    }
+
+    if (style.find("{") != 0) {
+        throw std::invalid_argument("style must be a JSON string");
+    }
+
+    Timer styleTimer;
+    TraceSpan span("setStyle", "style", {{"diff", diff ? "true" : "false"}});
+    ResourceAccounting::Scope accountingScope(accounting);
+    if (diff && applyStyleDiff(style)) {
+        currentStyleJSON = style;
+        accounting->addStyle(style);
+    } else {
+        loadStyleJSON(style);
+        currentStyleJSON.reset();
+    }
+    currentPhases.styleLoad += styleTimer.elapsed();
+}
+
+const bool Map::tileHasData(uint32_t z, uint32_t x, uint32_t y, double buffer) {
+    validateZoom(z);
+    if (x >= (1u << z) || y >= (1u << z)) {
+        throw std::invalid_argument("x and y must be less than 2^z");
+    }
+    if (buffer < 0) {
+        throw std::domain_error("buffer must be at least 0");
+    }
+    return accounting->getCoverage().tileHasData(listSources(), z, x, y, buffer);
+}
+
+void Map::trim(bool aggressive) {
+    auto renderer = frontend->getRenderer();
+    if (renderer == nullptr) {
+        return;
+    }
+
+    if (aggressive) {
+        renderer->clearData();
+    } else {
+        renderer->reduceMemoryUse();
+    }
+}
+
+void Map::setZoom(const double &zoom) {
+    validateZoom(zoom);
+    map->jumpTo(mbgl::CameraOptions().withZoom(zoom));
+}
+
+void Map::render() {
+    TraceSpan span("render", "render");
+    Timer timer;
+    renderStill();
+    finishRenderStats(timer);
+}
+
+const std::string Map::renderPNG() {
+    TraceSpan span("renderPNG", "render");
+    Timer timer;
+
+    // render produces premultiplied image; unpremultiply it
+    auto premultiplied = renderStill();
+    Timer phaseTimer;
+    auto image = [&]() {
+        TraceSpan span("unpremultiply", "render");
+        return mbgl::util::unpremultiply(std::move(premultiplied));
+    }();
+    currentPhases.unpremultiply = phaseTimer.elapsed();
+
+    phaseTimer.reset();
+    std::string out = [&]() {
+        TraceSpan span("encode", "render");
+        return encodePNG(image);
+    }();
+    currentPhases.encode = phaseTimer.elapsed();
+
+    finishRenderStats(timer);
 
     return out;
 }
 
+void Map::renderPNGToFile(int fd) {
+    if (fd < 0) {
+        throw std::invalid_argument("fd must be a valid file descriptor");
+    }
+
+    TraceSpan span("renderPNGToFile", "render");
+    Timer timer;
+
+    // render produces premultiplied image; unpremultiply it
+    auto premultiplied = renderStill();
+    Timer phaseTimer;
+    auto image = [&]() {
+        TraceSpan span("unpremultiply", "render");
+        return mbgl::util::unpremultiply(std::move(premultiplied));
+    }();
+    currentPhases.unpremultiply = phaseTimer.elapsed();
+
+    // encoded bytes are written as they are produced instead of to a buffer
+    phaseTimer.reset();
+    {
+        TraceSpan span("encode", "render");
+        PNGWriter writer(
+            image.size.width, image.size.height, [fd](const uint8_t *data, size_t size) {
+                writeAll(fd, data, size);
+            });
+        writer.writeRows(image.data.get(), image.size.height);
+    }
+    currentPhases.encode = phaseTimer.elapsed();
+
+    finishRenderStats(timer);
+}
+
+void Map::renderPNGToFile(const std::string &filename) {
+    int fd = openForWrite(filename);
+    try {
+        renderPNGToFile(fd);
+    } catch (...) {
+        ::close(fd);
+        ::unlink(filename.c_str());
+        throw;
+    }
+
+    if (::close(fd) != 0) {
+        throw std::runtime_error("could not write " + filename + ": " + std::strerror(errno));
+    }
+}
+
+const uint64_t Map::renderToSharedMemory(const std::string &name) {
+    TraceSpan span("renderToSharedMemory", "render");
+    Timer timer;
+
+    // render produces premultiplied image; unpremultiply it
+    auto premultiplied = renderStill();
+    Timer phaseTimer;
+    auto image = [&]() {
+        TraceSpan span("unpremultiply", "render");
+        return mbgl::util::unpremultiply(std::move(premultiplied));
+    }();
+    currentPhases.unpremultiply = phaseTimer.elapsed();
+
+    const uint64_t sequence = [&]() {
+        TraceSpan span("writeSharedFrame", "render");
+        return writeSharedFrame(name, image, pixelRatio);
+    }();
+
+    finishRenderStats(timer);
+
+    return sequence;
+}
+
 const std::unique_ptr<uint8_t[]> Map::renderBuffer() {
+    TraceSpan span("renderBuffer", "render");
+    Timer timer;
+
     // render produces premultiplied image; unpremultiply it
-    auto image = mbgl::util::unpremultiply(frontend->render(*map).image);
+    auto premultiplied = renderStill();
+    Timer phaseTimer;
+    auto image = [&]() {
+        TraceSpan span("unpremultiply", "render");
+        return mbgl::util::unpremultiply(std::move(premultiplied));
+    }();
+    currentPhases.unpremultiply = phaseTimer.elapsed();
+
+    finishRenderStats(timer);
 
     return std::move(image.data);
 }
 
+const std::vector<std::string> Map::renderMany(const std::vector<Camera> &cameras,
+                                               const std::string &format) {
+    if (format != "png" && format != "buffer") {
+        throw std::invalid_argument("format must be one of: png, buffer");
+    }
+
+    // validate all cameras before rendering any frames
+    for (const auto &camera : cameras) {
+        validateCenter(camera.longitude, camera.latitude);
+        validateZoom(camera.zoom);
+        validateBearing(camera.bearing);
+        validatePitch(camera.pitch);
+    }
+
+    TraceSpan span("renderMany", "render", {{"frames", std::to_string(cameras.size())}});
+
+    const mbgl::CameraOptions previous = map->getCameraOptions();
+
+    // frames are unpremultiplied and encoded while the next frame is rendered
+    std::vector<std::string> out(cameras.size());
+    RenderPhases pipelinePhases;
+    FramePipeline pipeline([&](uint64_t index, mbgl::PremultipliedImage premultiplied) {
+        out[index] = encodeFrame(std::move(premultiplied), format, pipelinePhases);
+    });
+
+    try {
+        for (const auto &camera : cameras) {
+            Timer timer;
+            jumpTo(camera);
+            auto image = renderStill();
+            finishRenderStats(timer);
+            pipeline.push(std::move(image));
+        }
+        pipeline.finish();
+    } catch (...) {
+        map->jumpTo(previous);
+        throw;
+    }
+
+    map->jumpTo(previous);
+    addPipelinedPhases(pipelinePhases);
+
+    return out;
+}
+
+const uint64_t Map::renderPath(const std::vector<Keyframe> &keyframes,
+                               double fps,
+                               const FrameCallback &callback) {
+    if (keyframes.empty()) {
+        throw std::invalid_argument("keyframes must not be empty");
+    }
+    if (!(fps > 0)) {
+        throw std::domain_error("fps must be greater than 0");
+    }
+    for (size_t i = 0; i < keyframes.size(); i++) {
+        const Keyframe &keyframe = keyframes[i];
+        if (keyframe.time < 0 || (i > 0 && keyframe.time < keyframes[i - 1].time)) {
+            throw std::invalid_argument("keyframe times must be at least 0 and in order");
+        }
+        validateCenter(keyframe.camera.longitude, keyframe.camera.latitude);
+        validateZoom(keyframe.camera.zoom);
+        validateBearing(keyframe.camera.bearing);
+        validatePitch(keyframe.camera.pitch);
+        ease(keyframe.easing, 0);
+    }
+
+    const double start    = keyframes.front().time;
+    const double duration = keyframes.back().time - start;
+    // include a frame at the end of the path; allow for rounding error
+    const uint64_t frames = static_cast<uint64_t>(std::floor(duration * fps + 1e-9)) + 1;
+
+    TraceSpan span("renderPath", "render", {{"frames", std::to_string(frames)}});
+
+    const mbgl::CameraOptions previous = map->getCameraOptions();
+
+    // frames are unpremultiplied and passed to callback while the next frame
+    // is rendered
+    RenderPhases pipelinePhases;
+    FramePipeline pipeline([&](uint64_t, mbgl::PremultipliedImage premultiplied) {
+        Timer phaseTimer;
+        auto image = [&]() {
+            TraceSpan span("unpremultiply", "render");
+            return mbgl::util::unpremultiply(std::move(premultiplied));
+        }();
+        pipelinePhases.unpremultiply += phaseTimer.elapsed();
+
+        TraceSpan span("writeFrame", "render");
+        callback(image.data.get(), image.bytes());
+    });
+
+    try {
+        for (uint64_t i = 0; i < frames; i++) {
+            Timer timer;
+            jumpTo(interpolateCamera(keyframes, start + i / fps));
+            auto image = renderStill();
+            finishRenderStats(timer);
+            pipeline.push(std::move(image));
+        }
+        pipeline.finish();
+    } catch (...) {
+        map->jumpTo(previous);
+        throw;
+    }
+
+    map->jumpTo(previous);
+    addPipelinedPhases(pipelinePhases);
+
+    return frames;
+}
+
+const uint64_t Map::renderPath(const std::vector<Keyframe> &keyframes, double fps, int fd) {
+    if (fd < 0) {
+        throw std::invalid_argument("fd must be a valid file descriptor");
+    }
+
+    return renderPath(keyframes, fps, [fd](const uint8_t *data, size_t size) {
+        writeAll(fd, data, size);
+    });
+}
+
+const std::string Map::renderRegion(uint32_t x,
+                                    uint32_t y,
+                                    uint32_t width,
+                                    uint32_t height,
+                                    const std::string &format) {
+    if (format != "png" && format != "buffer") {
+        throw std::invalid_argument("format must be one of: png, buffer");
+    }
+    validateDimension(width, "width");
+    validateDimension(height, "height");
+
+    const auto previousSize = getSize();
+    if (uint64_t(x) + width > previousSize.first || uint64_t(y) + height > previousSize.second) {
+        throw std::invalid_argument("region must be within the size of the map");
+    }
+
+    const mbgl::CameraOptions previous = map->getCameraOptions();
+    if (previous.pitch.value_or(0) != 0) {
+        throw std::runtime_error("pitch must be 0 to render a region");
+    }
+
+    TraceSpan span("renderRegion",
+                   "render",
+                   {{"width", std::to_string(width)}, {"height", std::to_string(height)}});
+    Timer timer;
+
+    // without pitch, a viewport of the size of the region centered on the
+    // center of the region draws the same pixels as the full map, including
+    // when it is rotated
+    const mbgl::LatLng center
+        = map->latLngForPixel(mbgl::ScreenCoordinate{x + width / 2.0, y + height / 2.0});
+
+    mbgl::PremultipliedImage premultiplied;
+    try {
+        setSize(width, height);
+        map->jumpTo(mbgl::CameraOptions().withCenter(center));
+        premultiplied = renderStill();
+    } catch (...) {
+        setSize(previousSize.first, previousSize.second);
+        map->jumpTo(previous);
+        throw;
+    }
+    setSize(previousSize.first, previousSize.second);
+    map->jumpTo(previous);
+
+    std::string out = encodeFrame(std::move(premultiplied), format, currentPhases);
+    finishRenderStats(timer);
+
+    return out;
+}
+
+const RenderedImage Map::renderWithInfo(const std::string &format) {
+    if (format != "png" && format != "buffer") {
+        throw std::invalid_argument("format must be one of: png, buffer");
+    }
+
+    TraceSpan span("renderWithInfo", "render");
+    Timer timer;
+
+    RenderedImage out = encodeFrameWithInfo(renderStill(), format, currentPhases);
+    finishRenderStats(timer);
+
+    return out;
+}
+
+const std::vector<std::string> Map::renderAtRatios(const std::vector<float> &ratios,
+                                                   const std::string &format) {
+    if (format != "png" && format != "buffer") {
+        throw std::invalid_argument("format must be one of: png, buffer");
+    }
+
+    // validate all ratios before rendering any frames
+    for (const auto &ratio : ratios) {
+        validatePixelRatio(ratio);
+        if (ratio != pixelRatio && pendingOperations) {
+            throw std::runtime_error("cannot set pixel ratio while a batch is in progress");
+        }
+    }
+
+    TraceSpan span("renderAtRatios", "render", {{"frames", std::to_string(ratios.size())}});
+    ResourceAccounting::Scope accountingScope(accounting);
+
+    std::vector<std::string> out(ratios.size());
+    auto renderFrames = [&](float ratio) {
+        for (size_t i = 0; i < ratios.size(); i++) {
+            if (ratios[i] == ratio) {
+                Timer timer;
+                out[i] = encodeFrame(renderStill(), format, currentPhases);
+                finishRenderStats(timer);
+            }
+        }
+    };
+
+    // frames at the current ratio are rendered first, without recreating the
+    // renderer
+    const float previous = pixelRatio;
+    renderFrames(previous);
+
+    // The current renderer is kept, with its tiles, while a renderer is
+    // created for each other ratio, and the sources and layers are moved back
+    // to it afterwards, so that restoring the ratio does not recreate the
+    // renderer or parse tiles again.
+    std::unique_ptr<mbgl::HeadlessFrontend> originalFrontend;
+    std::unique_ptr<mbgl::Map> originalMap;
+    auto restore = [&]() {
+        if (!originalMap) {
+            return;
+        }
+        moveStyleContents(*map, *originalMap);
+        map            = std::move(originalMap);
+        frontend       = std::move(originalFrontend);
+        pixelRatio     = previous;
+        renderingStats = mbgl::gfx::RenderingStats();
+    };
+
+    std::vector<float> rendered = {previous};
+    try {
+        for (const auto &ratio : ratios) {
+            if (std::find(rendered.begin(), rendered.end(), ratio) != rendered.end()) {
+                continue;
+            }
+            rendered.push_back(ratio);
+
+            TraceSpan ratioSpan("setPixelRatio", "map", {{"ratio", std::to_string(ratio)}});
+            auto [nextFrontend, nextMap] = createRenderer(ratio);
+            moveStyleContents(*map, *nextMap);
+            if (originalMap) {
+                // the map must be destroyed before its frontend
+                map.reset();
+            } else {
+                originalMap      = std::move(map);
+                originalFrontend = std::move(frontend);
+            }
+            map        = std::move(nextMap);
+            frontend   = std::move(nextFrontend);
+            pixelRatio = ratio;
+
+            renderFrames(ratio);
+        }
+    } catch (...) {
+        restore();
+        throw;
+    }
+
+    restore();
+
+    return out;
+}
+
+void Map::renderTiledPNG(const std::string &filename,
+                         uint32_t width,
+                         uint32_t height,
+                         uint32_t tileSize,
+                         uint32_t overlap) {
+    validateDimension(width, "width");
+    validateDimension(height, "height");
+    validateDimension(tileSize, "tileSize");
+
+    const mbgl::CameraOptions previous = map->getCameraOptions();
+    if (previous.bearing.value_or(0) != 0 || previous.pitch.value_or(0) != 0) {
+        throw std::runtime_error("bearing and pitch must be 0 to render a tiled image");
+    }
+
+    TraceSpan span("renderTiledPNG",
+                   "render",
+                   {{"width", std::to_string(width)}, {"height", std::to_string(height)}});
+
+    const auto previousSize   = getSize();
+    const uint32_t renderSize = tileSize + 2 * overlap;
+    const uint32_t columns    = (width + tileSize - 1) / tileSize;
+    const uint32_t rows       = (height + tileSize - 1) / tileSize;
+
+    // offsets in output pixels of a logical pixel offset, rounded down to
+    // whole pixels.  Each tile is positioned so that its pixels line up with
+    // the output pixels, so that tiles fit together exactly even if the pixel
+    // ratio is not an integer.
+    auto toPixels = [&](uint32_t value) { return static_cast<uint32_t>(value * pixelRatio); };
+    const uint32_t outWidth = toPixels(width);
+    const uint32_t offset   = toPixels(overlap);
+
+    // tile centers are offset from the center of the image in world pixels,
+    // which are the same as logical pixels when bearing and pitch are 0
+    const double scale                 = std::pow(2.0, previous.zoom.value_or(0));
+    const mbgl::LatLng center          = previous.center.value_or(mbgl::LatLng{0, 0});
+    const mbgl::Point<double> centerPx = mbgl::Projection::project(center, scale);
+
+    int fd = openForWrite(filename);
+    try {
+        PNGWriter writer(outWidth, toPixels(height), [fd](const uint8_t *data, size_t size) {
+            writeAll(fd, data, size);
+        });
+
+        // row of tiles being assembled before it is encoded
+        std::vector<uint8_t> band;
+
+        // tiles are cropped and copied into the band, which is encoded once
+        // it is complete, while the next tile is rendered
+        FramePipeline pipeline([&](uint64_t index, mbgl::PremultipliedImage premultiplied) {
+            const uint32_t column = index % columns;
+            const uint32_t row    = index / columns;
+
+            const uint32_t x0 = toPixels(column * tileSize);
+            const uint32_t x1 = toPixels(std::min((column + 1) * tileSize, width));
+            const uint32_t y0 = toPixels(row * tileSize);
+            const uint32_t y1 = toPixels(std::min((row + 1) * tileSize, height));
+
+            auto image = mbgl::util::unpremultiply(std::move(premultiplied));
+
+            const uint32_t copyWidth = std::min(x1 - x0, image.size.width - offset);
+            const uint32_t bandRows  = std::min(y1 - y0, image.size.height - offset);
+            band.resize(size_t(outWidth) * (y1 - y0) * 4);
+            for (uint32_t y = 0; y < bandRows; y++) {
+                const size_t from = (size_t(y + offset) * image.size.width + offset) * 4;
+                std::memcpy(band.data() + (size_t(y) * outWidth + x0) * 4,
+                            image.data.get() + from,
+                            size_t(copyWidth) * 4);
+            }
+
+            if (column == columns - 1) {
+                TraceSpan span("encodeRows", "render", {{"row", std::to_string(row)}});
+                writer.writeRows(band.data(), y1 - y0);
+                std::fill(band.begin(), band.end(), 0);
+            }
+        });
+
+        setSize(renderSize, renderSize);
+        for (uint32_t row = 0; row < rows; row++) {
+            for (uint32_t column = 0; column < columns; column++) {
+                // the first pixel of the rendered tile is offset pixels before
+                // the first output pixel of the tile
+                const double left = (double(toPixels(column * tileSize)) - offset) / pixelRatio;
+                const double top  = (double(toPixels(row * tileSize)) - offset) / pixelRatio;
+                const mbgl::Point<double> tileCenter{
+                    centerPx.x + left + renderSize / 2.0 - width / 2.0,
+                    centerPx.y + top + renderSize / 2.0 - height / 2.0};
+
+                Timer timer;
+                map->jumpTo(mbgl::CameraOptions().withCenter(
+                    mbgl::Projection::unproject(tileCenter, scale, mbgl::LatLng::Wrapped)));
+                auto image = renderStill();
+                finishRenderStats(timer);
+                pipeline.push(std::move(image));
+            }
+        }
+        pipeline.finish();
+
+        if (!writer.isComplete()) {
+            throw std::runtime_error("could not encode all rows of image");
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(filename.c_str());
+        setSize(previousSize.first, previousSize.second);
+        map->jumpTo(previous);
+        throw;
+    }
+
+    setSize(previousSize.first, previousSize.second);
+    map->jumpTo(previous);
+
+    // delayed write errors are reported when the file is closed
+    if (::close(fd) != 0) {
+        const std::string error = std::strerror(errno);
+        ::unlink(filename.c_str());
+        throw std::runtime_error("could not write " + filename + ": " + error);
+    }
+}
+
+const uint64_t Map::renderTiles(const std::vector<TileID> &tiles,
+                                TileWriter &writer,
+                                bool skipEmpty,
+                                double buffer) {
+    const auto size = getSize();
+    if (size.first != size.second) {
+        throw std::runtime_error("map must be square to render tiles");
+    }
+    if (buffer < 0) {
+        throw std::domain_error("buffer must be at least 0");
+    }
+
+    // tiles are 512 logical pixels at their own zoom
+    const double zoomOffset = std::log2(size.first / mbgl::util::tileSize_D);
+
+    // validate all tiles before rendering any of them
+    for (const auto &tile : tiles) {
+        if (tile.z + zoomOffset < 0) {
+            throw std::domain_error("map width must be at least 512 / 2^z to render tiles of zoom "
+                                    + std::to_string(tile.z));
+        }
+        validateZoom(tile.z + zoomOffset);
+        const uint64_t count = uint64_t(1) << tile.z;
+        if (tile.x >= count || tile.y >= count) {
+            throw std::invalid_argument("x and y must be less than 2^z");
+        }
+    }
+
+    TraceSpan span("renderTiles", "render", {{"tiles", std::to_string(tiles.size())}});
+
+    const mbgl::CameraOptions previous = map->getCameraOptions();
+
+    auto renderTile = [&](const TileID &tile) {
+        const double scale = std::pow(2.0, tile.z);
+        const mbgl::Point<double> tileCenter{(tile.x + 0.5) * mbgl::util::tileSize_D,
+                                             (tile.y + 0.5) * mbgl::util::tileSize_D};
+
+        Timer timer;
+        map->jumpTo(mbgl::CameraOptions()
+                        .withCenter(mbgl::Projection::unproject(tileCenter, scale))
+                        .withZoom(tile.z + zoomOffset)
+                        .withBearing(0.0)
+                        .withPitch(0.0));
+        auto image = renderStill();
+        finishRenderStats(timer);
+        return image;
+    };
+
+    uint64_t written = 0;
+    RenderPhases pipelinePhases;
+
+    try {
+        // Tiles without data still show the background of the style, which
+        // only varies by zoom.  The first empty tile of each zoom is rendered;
+        // if it is a single color, its image is written for the other empty
+        // tiles of that zoom, which are not rendered.  Otherwise, such as for
+        // a background pattern, empty tiles are rendered like any other.
+        // Tiles to render are selected up front so that they are not modified
+        // while the pipeline reads them.
+        const auto sources = listSources();
+        std::vector<TileID> selected;
+        std::map<uint32_t, std::optional<RenderedImage>> backgrounds;
+        for (const auto &tile : tiles) {
+            if (!skipEmpty
+                || accounting->getCoverage().tileHasData(
+                    sources, tile.z, tile.x, tile.y, buffer)) {
+                selected.push_back(tile);
+                continue;
+            }
+
+            auto background = backgrounds.find(tile.z);
+            if (background == backgrounds.end()) {
+                auto image = encodeFrameWithInfo(renderTile(tile), "png", pipelinePhases);
+                writer.addTile(tile.z, tile.x, tile.y, image.data, image.hash);
+                written++;
+
+                std::optional<RenderedImage> uniform;
+                if (image.uniformColor) {
+                    uniform = std::move(image);
+                }
+                backgrounds.emplace(tile.z, std::move(uniform));
+                continue;
+            }
+
+            if (!background->second) {
+                selected.push_back(tile);
+                continue;
+            }
+
+            TraceSpan span("writeTile", "render");
+            writer.addTile(
+                tile.z, tile.x, tile.y, background->second->data, background->second->hash);
+            written++;
+        }
+
+        // tiles are encoded and written while the next tile is rendered
+        FramePipeline pipeline([&](uint64_t index, mbgl::PremultipliedImage premultiplied) {
+            const TileID &tile = selected[index];
+            auto image = encodeFrameWithInfo(std::move(premultiplied), "png", pipelinePhases);
+
+            TraceSpan span("writeTile", "render");
+            writer.addTile(tile.z, tile.x, tile.y, image.data, image.hash);
+            written++;
+        });
+
+        for (const auto &tile : selected) {
+            pipeline.push(renderTile(tile));
+        }
+        pipeline.finish();
+        writer.flush();
+    } catch (...) {
+        map->jumpTo(previous);
+        throw;
+    }
+
+    map->jumpTo(previous);
+    addPipelinedPhases(pipelinePhases);
+
+    return written;
+}
+
+void Map::resetStats() {
+    stats         = RenderStats();
+    currentPhases = RenderPhases();
+}
+
 // private:
 
+bool Map::applyStyleDiff(const std::string &style) {
+    using namespace mbgl::style;
+    using namespace mbgl::style::conversion;
+
+    mbgl::JSDocument next;
+    next.Parse<0>(style.c_str(), style.length());
+    if (next.HasParseError()) {
+        throw std::runtime_error("error parsing style: " + mbgl::formatJSONParseError(next));
+    }
+
+    const std::string currentJSON = currentStyleJSON.value_or(map->getStyle().getJSON());
+    mbgl::JSDocument prev;
+    prev.Parse<0>(currentJSON.c_str(), currentJSON.length());
+
+    // let a full load report errors in malformed styles
+    if (prev.HasParseError() || !prev.IsObject() || !next.IsObject() || !next.HasMember("sources")
+        || !next["sources"].IsObject() || !next.HasMember("layers") || !next["layers"].IsArray()) {
+        return false;
+    }
+
+    // Top-level properties such as sprite, glyphs, light, or transition can
+    // only be set by loading the whole style.  Camera properties are ignored
+    // because the camera is owned by the map.
+    const std::unordered_set<std::string> diffableKeys
+        = {"sources", "layers", "name", "metadata", "center", "zoom", "bearing", "pitch"};
+
+    auto sameMember = [](const mbgl::JSValue &a, const mbgl::JSValue &b, const char *key) {
+        if (!a.HasMember(key) || !b.HasMember(key)) {
+            return a.HasMember(key) == b.HasMember(key);
+        }
+        return a[key] == b[key];
+    };
+
+    for (const auto &doc : {&prev, &next}) {
+        for (auto it = doc->MemberBegin(); it != doc->MemberEnd(); ++it) {
+            const char *key = it->name.GetString();
+            if (!diffableKeys.count(key) && !sameMember(prev, next, key)) {
+                return false;
+            }
+        }
+    }
+
+    auto &currentStyle = map->getStyle();
+    const mbgl::JSValue &nextSources = next["sources"];
+    const mbgl::JSValue *prevSources
+        = prev.HasMember("sources") && prev["sources"].IsObject() ? &prev["sources"] : nullptr;
+
+    // Sources are kept only if their definitions are unchanged, which retains
+    // their loaded tiles.  Sources added after the style was loaded are not in
+    // the previous style, so they are always replaced.
+    std::unordered_set<std::string> changedSources;
+    for (const auto *source : currentStyle.getSources()) {
+        const std::string id = source->getID();
+        if (id == "org.maplibre.annotations") {
+            continue;
+        }
+        const char *key = id.c_str();
+        if (!nextSources.HasMember(key) || prevSources == nullptr || !prevSources->HasMember(key)
+            || !((*prevSources)[key] == nextSources[key])) {
+            changedSources.insert(id);
+        }
+    }
+
+    // convert everything before modifying the style, so that an invalid
+    // source or layer leaves the style unchanged
+    std::vector<std::unique_ptr<Source>> addedSources;
+    std::unordered_set<std::string> nextSourceIDs;
+    for (auto it = nextSources.MemberBegin(); it != nextSources.MemberEnd(); ++it) {
+        const std::string id = it->name.GetString();
+        if (!nextSourceIDs.insert(id).second) {
+            throw std::invalid_argument("duplicate source id: " + id);
+        }
+        if (currentStyle.getSource(id) != nullptr && !changedSources.count(id)) {
+            continue;
+        }
+
+        Error error;
+        const mbgl::JSValue *value = &it->value;
+        auto source                = convert<std::unique_ptr<Source>>(value, error, id);
+        if (!source) {
+            throw std::invalid_argument("source " + id + ": " + error.message);
+        }
+        addedSources.push_back(std::move(*source));
+    }
+
+    std::vector<std::unique_ptr<Layer>> nextLayers;
+    std::vector<bool> keepLayer;
+    std::unordered_set<std::string> keptLayerIDs;
+    std::unordered_set<std::string> nextLayerIDs;
+    const mbgl::JSValue &layers = next["layers"];
+    for (rapidjson::SizeType i = 0; i < layers.Size(); i++) {
+        Error error;
+        const mbgl::JSValue *value = &layers[i];
+        auto layer                 = convert<std::unique_ptr<Layer>>(value, error);
+        if (!layer) {
+            throw std::invalid_argument(error.message);
+        }
+        // adding the second layer would fail after the style was modified
+        if (!nextLayerIDs.insert((*layer)->getID()).second) {
+            throw std::invalid_argument("duplicate layer id: " + (*layer)->getID());
+        }
+
+        const Layer *existing = currentStyle.getLayer((*layer)->getID());
+        bool keep = existing != nullptr && !changedSources.count(existing->getSourceID())
+                    && existing->serialize() == (*layer)->serialize();
+
+        if (keep) {
+            keptLayerIDs.insert((*layer)->getID());
+        }
+        keepLayer.push_back(keep);
+        nextLayers.push_back(std::move(*layer));
+    }
+
+    // Layers that are kept must already be in the same relative order; the
+    // style API cannot move a layer without re-adding it.
+    std::vector<std::string> keptOrder;
+    for (size_t i = 0; i < nextLayers.size(); i++) {
+        if (keepLayer[i]) {
+            keptOrder.push_back(nextLayers[i]->getID());
+        }
+    }
+    std::vector<std::string> currentOrder;
+    for (const auto *layer : currentStyle.getLayers()) {
+        if (keptLayerIDs.count(layer->getID())) {
+            currentOrder.push_back(layer->getID());
+        }
+    }
+    if (keptOrder != currentOrder) {
+        return false;
+    }
+
+    // Everything that can fail is checked above, but if the style still
+    // rejects a change, it is partly applied; load the whole style instead.
+    try {
+        // remove layers before the sources they reference
+        for (const auto &layerID : listLayers()) {
+            if (!keptLayerIDs.count(layerID)) {
+                currentStyle.removeLayer(layerID);
+            }
+        }
+        for (const auto &sourceID : changedSources) {
+            currentStyle.removeSource(sourceID);
+        }
+        for (auto &source : addedSources) {
+            currentStyle.addSource(std::move(source));
+        }
+
+        // insert new or changed layers from the top down, each before the
+        // layer that follows it in the new style
+        std::optional<std::string> before;
+        for (size_t i = nextLayers.size(); i-- > 0;) {
+            const std::string layerID = nextLayers[i]->getID();
+            if (!keepLayer[i]) {
+                currentStyle.addLayer(std::move(nextLayers[i]), before);
+            }
+            before = layerID;
+        }
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+mbgl::PremultipliedImage Map::renderStill() {
+    renderTimer.reset();
+    const double traceStart = tracing::now();
+    ResourceAccounting::Scope accountingScope(accounting);
+
+    // equivalent to HeadlessFrontend::render, which is not instrumented.  In
+    // static mode, the still image callback is called as soon as a fully
+    // loaded frame has been drawn, so the frame that is read back was drawn
+    // in the last iteration of the run loop.  That iteration may also handle
+    // other events, such as tiles finishing parsing, so draw is an upper bound.
+    mbgl::PremultipliedImage image;
+    std::exception_ptr error;
+    double drawStart = 0;
+    double drawEnd   = 0;
+    map->renderStill([&](const std::exception_ptr &e) {
+        drawEnd = renderTimer.elapsed();
+        if (e) {
+            error = e;
+        } else {
+            image          = frontend->readStillImage();
+            renderingStats = frontend->getBackend()->getContext().renderingStats();
+        }
+    });
+
+    while (!image.valid() && !error) {
+        drawStart = renderTimer.elapsed();
+        loop->runOnce();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    const double end       = renderTimer.elapsed();
+    currentPhases.load     = drawStart;
+    currentPhases.draw     = drawEnd - drawStart;
+    currentPhases.readback = end - drawEnd;
+
+    // record phases as consecutive spans in microseconds, as for
+    // tracing::now(); phases that took no measurable time, such as load when
+    // everything was already loaded, are omitted
+    if (tracing::isEnabled()) {
+        const std::vector<std::pair<std::string, double>> phases
+            = {{"load", currentPhases.load},
+               {"draw", currentPhases.draw},
+               {"readback", currentPhases.readback}};
+
+        double timestamp = traceStart;
+        for (const auto &[name, duration] : phases) {
+            if (duration > 0) {
+                tracing::complete(name, "render", timestamp, duration * 1000);
+            }
+            timestamp += duration * 1000;
+        }
+    }
+
+    return image;
+}
+
+void Map::finishRenderStats(const Timer &timer) {
+    currentPhases.total = timer.elapsed() + currentPhases.styleLoad;
+
+    stats.frames++;
+    stats.last = currentPhases;
+    stats.cumulative += currentPhases;
+    currentPhases = RenderPhases();
+}
+
+void Map::addPipelinedPhases(const RenderPhases &phases) {
+    stats.cumulative.unpremultiply += phases.unpremultiply;
+    stats.cumulative.encode += phases.encode;
+    stats.cumulative.total += phases.unpremultiply + phases.encode;
+}
+
+std::string Map::encodeFrame(mbgl::PremultipliedImage premultiplied,
+                             const std::string &format,
+                             RenderPhases &phases) {
+    Timer phaseTimer;
+    auto image = [&]() {
+        TraceSpan span("unpremultiply", "render");
+        return mbgl::util::unpremultiply(std::move(premultiplied));
+    }();
+    phases.unpremultiply += phaseTimer.elapsed();
+
+    if (format != "png") {
+        return std::string(reinterpret_cast<const char *>(image.data.get()), image.bytes());
+    }
+
+    phaseTimer.reset();
+    TraceSpan span("encode", "render");
+    std::string out = encodePNG(image);
+    phases.encode += phaseTimer.elapsed();
+    return out;
+}
+
+RenderedImage Map::encodeFrameWithInfo(mbgl::PremultipliedImage premultiplied,
+                                       const std::string &format,
+                                       RenderPhases &phases) {
+    RenderedImage out;
+
+    const auto premultipliedColor
+        = uniformColor(premultiplied.data.get(), premultiplied.size.area());
+    if (!premultipliedColor) {
+        out.data = encodeFrame(std::move(premultiplied), format, phases);
+        out.hash = xxhash64(reinterpret_cast<const uint8_t *>(out.data.data()), out.data.size());
+        return out;
+    }
+
+    const mbgl::Size size = premultiplied.size;
+
+    // unpremultiply only the color
+    auto pixel = mbgl::util::unpremultiply(mbgl::PremultipliedImage(
+        {1, 1}, premultipliedColor->data(), premultipliedColor->size()));
+    const Color color{pixel.data[0], pixel.data[1], pixel.data[2], pixel.data[3]};
+    out.uniformColor = color;
+
+    if (format == "png") {
+        Timer phaseTimer;
+        uint32_t packed;
+        std::memcpy(&packed, color.data(), sizeof(packed));
+        const auto key = std::make_tuple(size.width, size.height, packed);
+
+        auto cached = uniformPNGs.find(key);
+        if (cached == uniformPNGs.end()) {
+            // few colors are expected, but bound the cache anyway
+            if (uniformPNGs.size() >= 64) {
+                uniformPNGs.clear();
+            }
+            std::string png = encodeUniformPNG(size.width, size.height, color);
+            cached          = uniformPNGs.emplace(key, std::move(png)).first;
+        }
+        out.data = cached->second;
+        phases.encode += phaseTimer.elapsed();
+    } else {
+        out.data.resize(size.area() * 4);
+        for (size_t i = 0; i < out.data.size(); i += 4) {
+            std::memcpy(out.data.data() + i, color.data(), 4);
+        }
+    }
+
+    out.hash = xxhash64(reinterpret_cast<const uint8_t *>(out.data.data()), out.data.size());
+    return out;
+}
+
+void Map::jumpTo(const Camera &camera) {
+    map->jumpTo(mbgl::CameraOptions()
+                    .withCenter(mbgl::LatLng{camera.latitude, camera.longitude})
+                    .withZoom(camera.zoom)
+                    .withBearing(camera.bearing)
+                    .withPitch(camera.pitch));
+}
+
+void Map::loadStyleJSON(const std::string &style) {
+    observer->didFailLoadingMapCallback
+        = [&](mbgl::MapLoadError type, const std::string &description) {
+              throw std::runtime_error(description);
+          };
+
+    map->getStyle().loadJSON(style);
+    accounting->addStyle(style);
+
+    // images added to the previous style are dropped with it
+    imageBytes.clear();
+}
+
 void Map::validateBearing(const double &bearing) {
     if (bearing < 0) {
         throw std::domain_error("bearing must be at least 0");
@@ -626,6 +2198,19 @@ void Map::validateBearing(const double &bearing) {
     }
 }
 
+void Map::validateCenter(const double &longitude, const double &latitude) {
+    // match mbgl::LatLng, which otherwise throws once the camera is set
+    if (std::isnan(latitude)) {
+        throw std::domain_error("latitude must not be NaN");
+    }
+    if (std::abs(latitude) > 90) {
+        throw std::domain_error("latitude must be between -90 and 90");
+    }
+    if (!std::isfinite(longitude)) {
+        throw std::domain_error("longitude must be finite");
+    }
+}
+
 void Map::validateDimension(const uint32_t &value, const std::string dimType) {
     if (value <= 0) {
         throw std::domain_error(dimType + " must be greater than 0");
@@ -647,7 +2232,7 @@ void Map::validatePixelRatio(const float &ratio) {
         throw std::domain_error("ratio must be greater than 0");
     }
     // arbitrary cutoff
-    if (ratio > 85) {
+    if (ratio > 8) {
         throw std::domain_error("ratio must be no greater than 8");
     }
 }
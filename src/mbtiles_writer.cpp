@@ -0,0 +1,182 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <mbgl/storage/sqlite3.hpp>
+
+#include "mbtiles_writer.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+// Images are identified by the hex string of their hash; images with the
+// same hash but different data are numbered after it
+std::string toImageID(uint64_t hash, uint32_t n) {
+    char out[28];
+    if (n == 0) {
+        std::snprintf(out, sizeof(out), "%016llx", static_cast<unsigned long long>(hash));
+    } else {
+        std::snprintf(
+            out, sizeof(out), "%016llx-%u", static_cast<unsigned long long>(hash), n);
+    }
+    return out;
+}
+
+} // namespace
+
+MBTilesWriter::MBTilesWriter(const std::string &filename, uint32_t batchSize)
+    : batchSize(batchSize) {
+    if (batchSize == 0) {
+        throw std::domain_error("batchSize must be greater than 0");
+    }
+
+    db = std::make_unique<mapbox::sqlite::Database>(
+        mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadWriteCreate));
+
+    // tiles is a view of map and images; an MBTiles file with a tiles table
+    // cannot be added to
+    {
+        mapbox::sqlite::Statement stmt(*db, "SELECT type FROM sqlite_master WHERE name = 'tiles'");
+        mapbox::sqlite::Query query(stmt);
+        if (query.run() && query.get<std::string>(0) != "view") {
+            throw std::runtime_error(filename + " has a tiles table and cannot be written to");
+        }
+    }
+
+    db->exec("CREATE TABLE IF NOT EXISTS metadata (name TEXT PRIMARY KEY, value TEXT);"
+             "CREATE TABLE IF NOT EXISTS map ("
+             "    zoom_level INTEGER,"
+             "    tile_column INTEGER,"
+             "    tile_row INTEGER,"
+             "    tile_id TEXT,"
+             "    PRIMARY KEY (zoom_level, tile_column, tile_row)"
+             ");"
+             "CREATE TABLE IF NOT EXISTS images (tile_id TEXT PRIMARY KEY, tile_data BLOB);"
+             "CREATE VIEW IF NOT EXISTS tiles AS"
+             "    SELECT map.zoom_level AS zoom_level,"
+             "        map.tile_column AS tile_column,"
+             "        map.tile_row AS tile_row,"
+             "        images.tile_data AS tile_data"
+             "    FROM map JOIN images ON images.tile_id = map.tile_id;");
+
+    selectImage = std::make_unique<mapbox::sqlite::Statement>(
+        *db, "SELECT tile_data FROM images WHERE tile_id = ?1");
+    insertImage = std::make_unique<mapbox::sqlite::Statement>(
+        *db, "INSERT INTO images (tile_id, tile_data) VALUES (?1, ?2)");
+    insertTile = std::make_unique<mapbox::sqlite::Statement>(
+        *db,
+        "INSERT OR REPLACE INTO map (zoom_level, tile_column, tile_row, tile_id) "
+        "VALUES (?1, ?2, ?3, ?4)");
+}
+
+MBTilesWriter::~MBTilesWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void MBTilesWriter::setMetadata(const std::string &name, const std::string &value) {
+    if (!db) {
+        throw std::runtime_error("cannot write to a closed MBTiles file");
+    }
+
+    mapbox::sqlite::Statement stmt(
+        *db, "INSERT OR REPLACE INTO metadata (name, value) VALUES (?1, ?2)");
+    mapbox::sqlite::Query query(stmt);
+    query.bind(1, name);
+    query.bind(2, value);
+    query.run();
+}
+
+void MBTilesWriter::addTile(
+    uint32_t z, uint32_t x, uint32_t y, const std::string &data, uint64_t hash) {
+    if (!db) {
+        throw std::runtime_error("cannot write to a closed MBTiles file");
+    }
+    if (z > 30 || x >= (1u << z) || y >= (1u << z)) {
+        throw std::invalid_argument("invalid tile: " + std::to_string(z) + "/" + std::to_string(x)
+                                    + "/" + std::to_string(y));
+    }
+
+    if (!transaction) {
+        begin();
+    }
+
+    // the hash only finds candidates; an image is reused only if its data
+    // is the same, so that a collision or a wrong hash from the caller
+    // doesn't make this tile show another tile's image
+    std::string imageID;
+    bool found = false;
+    for (uint32_t n = 0; !found; n++) {
+        imageID = toImageID(hash, n);
+
+        mapbox::sqlite::Query query(*selectImage);
+        query.bind(1, imageID);
+        if (!query.run()) {
+            break;
+        }
+        const std::string stored = query.get<std::string>(0);
+        found = stored.size() == data.size()
+                && std::memcmp(stored.data(), data.data(), data.size()) == 0;
+    }
+
+    if (!found) {
+        mapbox::sqlite::Query query(*insertImage);
+        query.bind(1, imageID);
+        query.bindBlob(2, data.data(), data.size(), false);
+        query.run();
+        imageCount++;
+    }
+
+    {
+        mapbox::sqlite::Query query(*insertTile);
+        query.bind(1, static_cast<int64_t>(z));
+        query.bind(2, static_cast<int64_t>(x));
+        // MBTiles rows are numbered from the south
+        query.bind(3, static_cast<int64_t>((1u << z) - 1 - y));
+        query.bind(4, imageID);
+        query.run();
+    }
+
+    tileCount++;
+    if (++pending >= batchSize) {
+        flush();
+    }
+}
+
+void MBTilesWriter::flush() {
+    if (transaction) {
+        transaction->commit();
+        transaction.reset();
+    }
+    pending = 0;
+}
+
+void MBTilesWriter::close() {
+    if (!db) {
+        return;
+    }
+
+    flush();
+
+    // images of tiles that were replaced
+    db->exec("DELETE FROM images WHERE tile_id NOT IN (SELECT tile_id FROM map)");
+
+    selectImage.reset();
+    insertImage.reset();
+    insertTile.reset();
+    db.reset();
+}
+
+const uint64_t MBTilesWriter::getTileCount() { return tileCount; }
+
+const uint64_t MBTilesWriter::getImageCount() { return imageCount; }
+
+void MBTilesWriter::begin() {
+    transaction = std::make_unique<mapbox::sqlite::Transaction>(
+        *db, mapbox::sqlite::Transaction::Immediate);
+}
+
+} // namespace mgl_wrapper
@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "pmtiles_writer.h"
+#include "png_writer.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+const size_t headerSize = 127;
+
+// the header and root directory must fit in the first 16 KiB of the archive
+const size_t maxRootSize = 16384 - headerSize;
+
+// compression and tile types defined by the PMTiles specification
+const uint8_t compressionUnknown = 0;
+const uint8_t compressionNone    = 1;
+const uint8_t compressionGzip    = 2;
+const uint8_t tileTypeUnknown    = 0;
+const uint8_t tileTypePNG        = 2;
+const uint8_t tileTypeJPEG       = 3;
+const uint8_t tileTypeWebP       = 4;
+const uint8_t tileTypeAVIF       = 5;
+
+// Entry of a directory; a run length of 0 references a leaf directory
+struct DirectoryEntry {
+    uint64_t tileID;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t runLength;
+};
+
+// little endian writes; all supported platforms are little endian
+template <typename T>
+void writeValue(uint8_t *out, T value) {
+    std::memcpy(out, &value, sizeof(value));
+}
+
+void writeVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::string gzip(const std::string &data) {
+    z_stream stream = {};
+    // window bits of 16 + MAX_WBITS write a gzip header
+    if (deflateInit2(
+            &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY)
+        != Z_OK) {
+        throw std::runtime_error("could not compress data");
+    }
+
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in  = data.size();
+    stream.next_out  = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = out.size();
+
+    const int ret = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+        throw std::runtime_error("could not compress data");
+    }
+
+    out.resize(stream.total_out);
+    return out;
+}
+
+// Encode a directory as columns of varints: the number of entries, then the
+// delta of each tile ID, run lengths, lengths, and offsets.  Offsets are 0 if
+// the data of an entry immediately follows the previous entry, otherwise the
+// offset + 1.
+std::string serializeDirectory(const std::vector<DirectoryEntry> &entries) {
+    std::string out;
+    writeVarint(out, entries.size());
+
+    uint64_t lastID = 0;
+    for (const auto &entry : entries) {
+        writeVarint(out, entry.tileID - lastID);
+        lastID = entry.tileID;
+    }
+    for (const auto &entry : entries) {
+        writeVarint(out, entry.runLength);
+    }
+    for (const auto &entry : entries) {
+        writeVarint(out, entry.length);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i > 0 && entries[i].offset == entries[i - 1].offset + entries[i - 1].length) {
+            writeVarint(out, 0);
+        } else {
+            writeVarint(out, entries[i].offset + 1);
+        }
+    }
+
+    return gzip(out);
+}
+
+// Return the root directory and leaf directories of entries.  Entries are
+// split into leaf directories of increasing size until the root directory
+// that references them fits.
+std::pair<std::string, std::string> buildDirectories(const std::vector<DirectoryEntry> &entries) {
+    std::string root = serializeDirectory(entries);
+    if (root.size() <= maxRootSize) {
+        return {root, ""};
+    }
+
+    for (size_t leafSize = 4096;; leafSize *= 2) {
+        std::vector<DirectoryEntry> rootEntries;
+        std::string leaves;
+        for (size_t i = 0; i < entries.size(); i += leafSize) {
+            const size_t end = std::min(i + leafSize, entries.size());
+            const std::string leaf = serializeDirectory(
+                std::vector<DirectoryEntry>(entries.begin() + i, entries.begin() + end));
+            rootEntries.push_back(
+                {entries[i].tileID, leaves.size(), static_cast<uint32_t>(leaf.size()), 0});
+            leaves += leaf;
+        }
+
+        root = serializeDirectory(rootEntries);
+        if (root.size() <= maxRootSize) {
+            return {root, leaves};
+        }
+    }
+}
+
+uint8_t detectTileType(const std::string &data) {
+    if (data.compare(0, 8, "\x89PNG\r\n\x1a\n") == 0) {
+        return tileTypePNG;
+    }
+    if (data.compare(0, 3, "\xff\xd8\xff") == 0) {
+        return tileTypeJPEG;
+    }
+    if (data.size() >= 12 && data.compare(0, 4, "RIFF") == 0
+        && data.compare(8, 4, "WEBP") == 0) {
+        return tileTypeWebP;
+    }
+    if (data.size() >= 12 && data.compare(4, 8, "ftypavif") == 0) {
+        return tileTypeAVIF;
+    }
+    return tileTypeUnknown;
+}
+
+// Read length bytes at offset of a file descriptor, retrying partial reads
+void readAll(int fd, uint64_t offset, uint8_t *data, size_t length) {
+    while (length > 0) {
+        const ssize_t count = ::pread(fd, data, length, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            throw std::runtime_error("could not read tile data: "
+                                     + std::string(count < 0 ? std::strerror(errno) : "EOF"));
+        }
+        data += count;
+        offset += count;
+        length -= count;
+    }
+}
+
+// Coordinates in degrees times 10^7 of a position given as fractions of the
+// width of the world from the northwest corner
+int32_t toLongitudeE7(double x) {
+    return static_cast<int32_t>(std::lround((x * 360 - 180) * 1e7));
+}
+
+int32_t toLatitudeE7(double y) {
+    const double latitude = std::atan(std::sinh(M_PI * (1 - 2 * y))) * 180 / M_PI;
+    return static_cast<int32_t>(std::lround(latitude * 1e7));
+}
+
+} // namespace
+
+PMTilesWriter::PMTilesWriter(const std::string &filename) : filename(filename) {
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("could not open " + filename + ": " + std::strerror(errno));
+    }
+
+    // image data is held in a temporary file until the archive is written;
+    // it is unlinked immediately so that it is removed even if the process
+    // exits without closing the archive
+    const std::string dataFilename = filename + ".tmp";
+    dataFd = ::open(dataFilename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (dataFd < 0) {
+        const std::string error = std::strerror(errno);
+        ::close(fd);
+        ::unlink(filename.c_str());
+        throw std::runtime_error("could not open " + dataFilename + ": " + error);
+    }
+    ::unlink(dataFilename.c_str());
+}
+
+PMTilesWriter::~PMTilesWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void PMTilesWriter::setMetadata(const std::string &name, const std::string &value) {
+    if (fd < 0) {
+        throw std::runtime_error("cannot write to a closed PMTiles file");
+    }
+    metadata[name] = value;
+}
+
+void PMTilesWriter::addTile(
+    uint32_t z, uint32_t x, uint32_t y, const std::string &data, uint64_t hash) {
+    if (fd < 0) {
+        throw std::runtime_error("cannot write to a closed PMTiles file");
+    }
+    if (z > 30 || x >= (1u << z) || y >= (1u << z)) {
+        throw std::invalid_argument("invalid tile: " + std::to_string(z) + "/" + std::to_string(x)
+                                    + "/" + std::to_string(y));
+    }
+
+    if (tiles.empty()) {
+        tileType = detectTileType(data);
+    }
+
+    // the hash only finds candidates; an image is reused only if its data
+    // is the same, so that a collision or a wrong hash from the caller
+    // doesn't make this tile show another tile's image
+    std::optional<uint32_t> index;
+    std::vector<uint8_t> stored;
+    const auto [first, last] = imagesByHash.equal_range(hash);
+    for (auto it = first; it != last && !index; ++it) {
+        const Image &image = images[it->second];
+        if (image.length != data.size()) {
+            continue;
+        }
+        stored.resize(image.length);
+        readAll(dataFd, image.offset, stored.data(), image.length);
+        if (std::memcmp(stored.data(), data.data(), data.size()) == 0) {
+            index = it->second;
+        }
+    }
+
+    if (!index) {
+        writeAll(dataFd, reinterpret_cast<const uint8_t *>(data.data()), data.size());
+        index = static_cast<uint32_t>(images.size());
+        images.push_back({dataSize, static_cast<uint32_t>(data.size())});
+        imagesByHash.emplace(hash, *index);
+        dataSize += data.size();
+    }
+
+    tiles.push_back({zxyToTileID(z, x, y), *index});
+
+    const double scale = 1u << z;
+    minZoom            = std::min(minZoom, z);
+    maxZoom            = std::max(maxZoom, z);
+    minX               = std::min(minX, x / scale);
+    minY               = std::min(minY, y / scale);
+    maxX               = std::max(maxX, (x + 1) / scale);
+    maxY               = std::max(maxY, (y + 1) / scale);
+}
+
+void PMTilesWriter::flush() {}
+
+void PMTilesWriter::close() {
+    if (fd < 0) {
+        return;
+    }
+
+    try {
+        writeArchive();
+    } catch (...) {
+        ::close(fd);
+        ::close(dataFd);
+        fd     = -1;
+        dataFd = -1;
+        ::unlink(filename.c_str());
+        throw;
+    }
+
+    ::close(fd);
+    ::close(dataFd);
+    fd     = -1;
+    dataFd = -1;
+}
+
+const uint64_t PMTilesWriter::getTileCount() { return tiles.size(); }
+
+const uint64_t PMTilesWriter::getImageCount() { return images.size(); }
+
+void PMTilesWriter::writeArchive() {
+    // tiles that were added more than once keep their last image
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile &a, const Tile &b) {
+        return a.tileID < b.tileID;
+    });
+
+    // images are placed in the order of the first tile that uses them, so
+    // that tile data is clustered by tile ID; consecutive tiles with the same
+    // image are a single entry
+    std::vector<DirectoryEntry> entries;
+    std::vector<uint32_t> order;
+    std::unordered_map<uint32_t, uint64_t> offsets;
+    uint64_t tileDataLength = 0;
+    uint64_t addressed      = 0;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        const Tile &tile = tiles[i];
+        if (i + 1 < tiles.size() && tiles[i + 1].tileID == tile.tileID) {
+            continue;
+        }
+        addressed++;
+
+        const Image &image   = images[tile.image];
+        auto [placed, isNew] = offsets.emplace(tile.image, tileDataLength);
+        if (isNew) {
+            order.push_back(tile.image);
+            tileDataLength += image.length;
+        }
+
+        if (!entries.empty()) {
+            DirectoryEntry &last = entries.back();
+            if (last.offset == placed->second && last.tileID + last.runLength == tile.tileID) {
+                last.runLength++;
+                continue;
+            }
+        }
+        entries.push_back({tile.tileID, placed->second, image.length, 1});
+    }
+
+    const auto [root, leaves] = buildDirectories(entries);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    for (const auto &[name, value] : metadata) {
+        writer.Key(name.c_str(), name.size());
+        writer.String(value.c_str(), value.size());
+    }
+    writer.EndObject();
+    const std::string metadataJSON = gzip(std::string(buffer.GetString(), buffer.GetSize()));
+
+    const uint64_t rootOffset     = headerSize;
+    const uint64_t metadataOffset = rootOffset + root.size();
+    const uint64_t leavesOffset   = metadataOffset + metadataJSON.size();
+    const uint64_t tileDataOffset = leavesOffset + leaves.size();
+
+    // an empty archive covers the world
+    if (tiles.empty()) {
+        minZoom = 0;
+        minX    = 0;
+        minY    = 0;
+        maxX    = 1;
+        maxY    = 1;
+    }
+
+    uint8_t header[headerSize] = {0};
+    std::memcpy(header, "PMTiles", 7);
+    header[7] = 3;
+    writeValue<uint64_t>(header + 8, rootOffset);
+    writeValue<uint64_t>(header + 16, root.size());
+    writeValue<uint64_t>(header + 24, metadataOffset);
+    writeValue<uint64_t>(header + 32, metadataJSON.size());
+    writeValue<uint64_t>(header + 40, leavesOffset);
+    writeValue<uint64_t>(header + 48, leaves.size());
+    writeValue<uint64_t>(header + 56, tileDataOffset);
+    writeValue<uint64_t>(header + 64, tileDataLength);
+    writeValue<uint64_t>(header + 72, addressed);
+    writeValue<uint64_t>(header + 80, entries.size());
+    writeValue<uint64_t>(header + 88, order.size());
+    header[96]  = 1;
+    header[97]  = compressionGzip;
+    header[98]  = tileType == tileTypeUnknown ? compressionUnknown : compressionNone;
+    header[99]  = tileType;
+    header[100] = static_cast<uint8_t>(minZoom);
+    header[101] = static_cast<uint8_t>(maxZoom);
+    writeValue<int32_t>(header + 102, toLongitudeE7(minX));
+    writeValue<int32_t>(header + 106, toLatitudeE7(maxY));
+    writeValue<int32_t>(header + 110, toLongitudeE7(maxX));
+    writeValue<int32_t>(header + 114, toLatitudeE7(minY));
+    header[118] = static_cast<uint8_t>(minZoom);
+    writeValue<int32_t>(header + 119, toLongitudeE7((minX + maxX) / 2));
+    writeValue<int32_t>(header + 123, toLatitudeE7((minY + maxY) / 2));
+
+    writeAll(fd, header, headerSize);
+    for (const std::string *section : {&root, &metadataJSON, &leaves}) {
+        writeAll(fd, reinterpret_cast<const uint8_t *>(section->data()), section->size());
+    }
+
+    // copy each image from the temporary file in the order it was placed
+    std::vector<uint8_t> data;
+    for (const uint32_t index : order) {
+        const Image &image = images[index];
+        data.resize(image.length);
+        readAll(dataFd, image.offset, data.data(), image.length);
+        writeAll(fd, data.data(), image.length);
+    }
+}
+
+uint64_t zxyToTileID(uint32_t z, uint32_t x, uint32_t y) {
+    // number of tiles at all lower zooms
+    uint64_t tileID = ((uint64_t(1) << (2 * z)) - 1) / 3;
+
+    // position along a Hilbert curve; quadrants are rotated so that the curve
+    // is continuous, using unsigned wraparound since only lower bits are used
+    for (uint32_t s = z > 0 ? 1u << (z - 1) : 0; s > 0; s >>= 1) {
+        const uint64_t rx = (x & s) ? 1 : 0;
+        const uint64_t ry = (y & s) ? 1 : 0;
+        tileID += uint64_t(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return tileID;
+}
+
+} // namespace mgl_wrapper
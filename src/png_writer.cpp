@@ -0,0 +1,89 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include "png_writer.h"
+
+namespace mgl_wrapper {
+
+PNGWriter::PNGWriter(uint32_t width, uint32_t height, Write write)
+    : width(width), height(height), write(std::move(write)) {
+    struct spng_ihdr ihdr = {0};
+    ihdr.width            = width;
+    ihdr.height           = height;
+    ihdr.bit_depth        = 8;
+    ihdr.color_type       = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;
+
+    // use the same options as encodePNG
+    ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    spng_set_png_stream(ctx, &PNGWriter::onWrite, this);
+    spng_set_ihdr(ctx, &ihdr);
+    spng_set_option(ctx, SPNG_FILTER_CHOICE, SPNG_FILTER_CHOICE_NONE);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, 3);
+
+    int ret = spng_encode_image(
+        ctx, nullptr, 0, SPNG_FMT_PNG, SPNG_ENCODE_PROGRESSIVE | SPNG_ENCODE_FINALIZE);
+    if (ret) {
+        spng_ctx_free(ctx);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        throw std::runtime_error("could not encode image, error: "
+                                 + std::string(spng_strerror(ret)));
+    }
+}
+
+PNGWriter::~PNGWriter() { spng_ctx_free(ctx); }
+
+void PNGWriter::writeRows(const uint8_t *data, uint32_t rows) {
+    if (rowsWritten + rows > height) {
+        throw std::invalid_argument("cannot write more rows than the height of the image");
+    }
+
+    const size_t rowBytes = size_t(width) * 4;
+    for (uint32_t i = 0; i < rows; i++) {
+        int ret = spng_encode_row(ctx, data + i * rowBytes, rowBytes);
+        rowsWritten++;
+
+        // the last row returns SPNG_EOI once the image is finalized
+        if (ret && !(ret == SPNG_EOI && rowsWritten == height)) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            throw std::runtime_error("could not encode image, error: "
+                                     + std::string(spng_strerror(ret)));
+        }
+    }
+}
+
+const bool PNGWriter::isComplete() { return rowsWritten == height; }
+
+int PNGWriter::onWrite(spng_ctx *, void *user, void *data, size_t length) {
+    auto writer = static_cast<PNGWriter *>(user);
+    try {
+        writer->write(static_cast<const uint8_t *>(data), length);
+    } catch (...) {
+        writer->error = std::current_exception();
+        return SPNG_IO_ERROR;
+    }
+    return 0;
+}
+
+void writeAll(int fd, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("could not write: " + std::string(std::strerror(errno)));
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+} // namespace mgl_wrapper
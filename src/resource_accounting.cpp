@@ -0,0 +1,306 @@
+#include <mutex>
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/file_source_manager.hpp>
+#include <mbgl/storage/main_resource_loader.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/util/client_options.hpp>
+#include <mbgl/util/rapidjson.hpp>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "resource_accounting.h"
+#include "trace.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+thread_local std::shared_ptr<ResourceAccounting> currentAccounting;
+
+std::string toJSON(const mbgl::JSValue &value) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    value.Accept(writer);
+    return buffer.GetString();
+}
+
+std::vector<std::string> readTileURLs(const mbgl::JSValue &tileset) {
+    std::vector<std::string> urls;
+    if (tileset.IsObject() && tileset.HasMember("tiles") && tileset["tiles"].IsArray()) {
+        for (const auto &url : tileset["tiles"].GetArray()) {
+            if (url.IsString()) {
+                urls.push_back(url.GetString());
+            }
+        }
+    }
+    return urls;
+}
+
+// Wraps the default resource loader to record the response to each request
+class AccountingFileSource : public mbgl::FileSource {
+public:
+    AccountingFileSource(const mbgl::ResourceOptions &resourceOptions,
+                         const mbgl::ClientOptions &clientOptions)
+        : loader(std::make_unique<mbgl::MainResourceLoader>(resourceOptions, clientOptions)) {}
+
+    std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource,
+                                                Callback callback) override {
+        auto accounting = ResourceAccounting::current();
+        if (!accounting && !tracing::isEnabled()) {
+            return loader->request(resource, std::move(callback));
+        }
+
+        const double start = tracing::now();
+        return loader->request(
+            resource,
+            [accounting, resource, start, callback = std::move(callback)](
+                mbgl::Response response) {
+                const double duration = tracing::now() - start;
+                if (accounting) {
+                    accounting->record(resource, response, duration / 1000);
+                }
+                tracing::complete("request", "resource", start, duration, {{"url", resource.url}});
+
+                callback(std::move(response));
+            });
+    }
+
+    bool canRequest(const mbgl::Resource &resource) const override {
+        return loader->canRequest(resource);
+    }
+
+    bool supportsCacheOnlyRequests() const override {
+        return loader->supportsCacheOnlyRequests();
+    }
+
+    void pause() override { loader->pause(); }
+    void resume() override { loader->resume(); }
+
+    void setProperty(const std::string &key, const mapbox::base::Value &value) override {
+        loader->setProperty(key, value);
+    }
+
+    mapbox::base::Value getProperty(const std::string &key) const override {
+        return loader->getProperty(key);
+    }
+
+    void setResourceTransform(mbgl::ResourceTransform transform) override {
+        loader->setResourceTransform(std::move(transform));
+    }
+
+    void setResourceOptions(mbgl::ResourceOptions options) override {
+        loader->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions getResourceOptions() override { return loader->getResourceOptions(); }
+
+    void setClientOptions(mbgl::ClientOptions options) override {
+        loader->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions getClientOptions() override { return loader->getClientOptions(); }
+
+private:
+    std::unique_ptr<mbgl::FileSource> loader;
+};
+
+} // namespace
+
+void ResourceAccounting::install() {
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        mbgl::FileSourceManager::get()->registerFileSourceFactory(
+            mbgl::FileSourceType::ResourceLoader,
+            [](const mbgl::ResourceOptions &resourceOptions,
+               const mbgl::ClientOptions &clientOptions) {
+                return std::make_unique<AccountingFileSource>(resourceOptions, clientOptions);
+            });
+    });
+}
+
+ResourceAccounting::Scope::Scope(const std::shared_ptr<ResourceAccounting> &accounting)
+    : previous(currentAccounting) {
+    currentAccounting = accounting;
+}
+
+ResourceAccounting::Scope::~Scope() { currentAccounting = previous; }
+
+std::shared_ptr<ResourceAccounting> ResourceAccounting::current() { return currentAccounting; }
+
+void ResourceAccounting::addStyle(const std::string &style) {
+    mbgl::JSDocument d;
+    d.Parse<0>(style.c_str(), style.length());
+    if (d.HasParseError() || !d.IsObject() || !d.HasMember("sources")
+        || !d["sources"].IsObject()) {
+        return;
+    }
+
+    for (auto it = d["sources"].MemberBegin(); it != d["sources"].MemberEnd(); ++it) {
+        addSource(it->name.GetString(), toJSON(it->value));
+    }
+}
+
+void ResourceAccounting::addSource(const std::string &id, const std::string &options) {
+    coverage.addSource(id, options);
+
+    mbgl::JSDocument d;
+    d.Parse<0>(options.c_str(), options.length());
+    if (d.HasParseError() || !d.IsObject()) {
+        return;
+    }
+
+    // tilesets and images are referenced by url, and GeoJSON by data
+    std::vector<std::string> keys = readTileURLs(d);
+    for (const char *member : {"url", "data"}) {
+        if (d.HasMember(member) && d[member].IsString()) {
+            keys.push_back(d[member].GetString());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    sources[id] = std::move(keys);
+
+    if (d.HasMember("url") && d["url"].IsString()) {
+        tilesetURLs.insert(d["url"].GetString());
+    }
+
+    geoJSON.erase(id);
+    const bool isGeoJSON = d.HasMember("type") && d["type"].IsString()
+                           && std::string(d["type"].GetString()) == "geojson";
+    if (isGeoJSON && d.HasMember("data")) {
+        const mbgl::JSValue &data = d["data"];
+        geoJSON[id] = data.IsString() ? GeoJSONData{data.GetString(), 0}
+                                      : GeoJSONData{"", toJSON(data).size()};
+    }
+}
+
+bool ResourceAccounting::isTileset(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tilesetURLs.count(url) > 0;
+}
+
+void ResourceAccounting::setGeoJSON(const std::string &id,
+                                    const mapbox::geojson::geojson &data,
+                                    size_t bytes) {
+    coverage.setGeoJSON(id, data);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    geoJSON[id] = GeoJSONData{"", bytes};
+}
+
+void ResourceAccounting::record(const mbgl::Resource &resource,
+                                const mbgl::Response &response,
+                                double loadTime) {
+    // sources of a style loaded from a URL and tile URLs of a tileset loaded
+    // from a URL are only known once they are loaded
+    if (response.data && !response.error) {
+        if (resource.kind == mbgl::Resource::Kind::Style) {
+            addStyle(*response.data);
+        } else if (resource.kind == mbgl::Resource::Kind::Source) {
+            // tilesets and GeoJSON data provide the extent of their sources
+            coverage.addResponse(resource.url, *response.data);
+
+            if (isTileset(resource.url)) {
+                mbgl::JSDocument d;
+                d.Parse<0>(response.data->c_str(), response.data->length());
+                if (!d.HasParseError()) {
+                    auto urls = readTileURLs(d);
+                    if (!urls.empty()) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        tilesets[resource.url] = std::move(urls);
+                    }
+                }
+            }
+        }
+    }
+
+    const std::string &key = resource.tileData ? resource.tileData->urlTemplate : resource.url;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Counters &counters = resources[key];
+    counters.stats.requests++;
+    counters.stats.loadTime += loadTime;
+    if (response.data) {
+        counters.stats.bytes += response.data->size();
+        counters.lastBytes = response.data->size();
+    }
+    if (response.error) {
+        counters.stats.errors++;
+    }
+    if (response.notModified) {
+        counters.stats.notModified++;
+    }
+    if (resource.tileData) {
+        const auto &tile = *resource.tileData;
+        counters.tiles.insert((uint64_t(tile.z) << 56) | (uint64_t(tile.x) << 28) | tile.y);
+    }
+}
+
+const std::vector<std::pair<std::string, SourceStats>> ResourceAccounting::getSourceStats(
+    const std::vector<std::string> &sourceIDs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::pair<std::string, SourceStats>> out;
+    out.reserve(sourceIDs.size());
+
+    for (const auto &id : sourceIDs) {
+        std::vector<std::string> keys;
+        auto source = sources.find(id);
+        if (source != sources.end()) {
+            for (const auto &key : source->second) {
+                keys.push_back(key);
+                auto tileset = tilesets.find(key);
+                if (tileset != tilesets.end()) {
+                    keys.insert(keys.end(), tileset->second.begin(), tileset->second.end());
+                }
+            }
+        }
+
+        SourceStats stats;
+        std::unordered_set<std::string> counted;
+        for (const auto &key : keys) {
+            auto resource = resources.find(key);
+            if (resource == resources.end() || !counted.insert(key).second) {
+                continue;
+            }
+            const Counters &counters = resource->second;
+            stats.requests += counters.stats.requests;
+            stats.tiles += counters.tiles.size();
+            stats.bytes += counters.stats.bytes;
+            stats.errors += counters.stats.errors;
+            stats.notModified += counters.stats.notModified;
+            stats.loadTime += counters.stats.loadTime;
+        }
+
+        out.emplace_back(id, stats);
+    }
+
+    return out;
+}
+
+const uint64_t ResourceAccounting::getGeoJSONBytes(const std::vector<std::string> &sourceIDs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64_t bytes = 0;
+    for (const auto &id : sourceIDs) {
+        auto data = geoJSON.find(id);
+        if (data == geoJSON.end()) {
+            continue;
+        }
+        if (data->second.url.empty()) {
+            bytes += data->second.bytes;
+        } else {
+            auto resource = resources.find(data->second.url);
+            if (resource != resources.end()) {
+                bytes += resource->second.lastBytes;
+            }
+        }
+    }
+    return bytes;
+}
+
+SourceCoverage &ResourceAccounting::getCoverage() { return coverage; }
+
+} // namespace mgl_wrapper
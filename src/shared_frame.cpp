@@ -0,0 +1,107 @@
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shared_frame.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+const char magic[4]    = {'M', 'G', 'L', 'F'};
+const uint32_t version = 1;
+
+std::runtime_error sharedMemoryError(const std::string &message, const std::string &name) {
+    return std::runtime_error(message + " " + name + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+const uint64_t writeSharedFrame(const std::string &name,
+                                const mbgl::UnassociatedImage &image,
+                                float pixelRatio) {
+    if (name.empty() || name.find('/', 1) != std::string::npos) {
+        throw std::invalid_argument("shared memory name must be non-empty and not contain '/'");
+    }
+    // POSIX names start with '/'; allow it to be omitted, as for Python's
+    // multiprocessing.shared_memory
+    const std::string path = name[0] == '/' ? name : "/" + name;
+
+    // pixels follow the header, which is a multiple of the cache line size so
+    // that rows are aligned
+    const uint32_t stride     = image.size.width * 4;
+    const uint64_t dataOffset = sizeof(SharedFrameHeader);
+    const uint64_t size       = dataOffset + uint64_t(stride) * image.size.height;
+
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        throw sharedMemoryError("could not open shared memory", path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw sharedMemoryError("could not open shared memory", path);
+    }
+
+    // segments cannot be resized on all platforms, and resizing one that is
+    // mapped by a reader would fault when the reader accesses it; replace it
+    if (info.st_size != 0 && uint64_t(info.st_size) != size) {
+        close(fd);
+        shm_unlink(path.c_str());
+        fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            throw sharedMemoryError("could not create shared memory", path);
+        }
+        info.st_size = 0;
+    }
+
+    if (info.st_size == 0 && ftruncate(fd, size) != 0) {
+        close(fd);
+        throw sharedMemoryError("could not resize shared memory", path);
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw sharedMemoryError("could not map shared memory", path);
+    }
+
+    auto header = static_cast<SharedFrameHeader *>(mapped);
+    std::atomic_ref<uint64_t> sequence(header->sequence);
+
+    // continue the sequence of a segment written previously
+    uint64_t previous = 0;
+    if (std::memcmp(header->magic, magic, sizeof(magic)) == 0 && header->version == version) {
+        previous = sequence.load();
+        previous += previous % 2;
+    }
+
+    // the fence keeps the frame from becoming visible before the odd
+    // sequence, so that readers cannot accept a partially written frame
+    sequence.store(previous + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, magic, sizeof(magic));
+    header->version    = version;
+    header->width      = image.size.width;
+    header->height     = image.size.height;
+    header->stride     = stride;
+    header->format     = 0;
+    header->dataOffset = dataOffset;
+    header->pixelRatio = pixelRatio;
+
+    std::memcpy(static_cast<uint8_t *>(mapped) + dataOffset, image.data.get(), image.bytes());
+    sequence.store(previous + 2, std::memory_order_release);
+
+    munmap(mapped, size);
+
+    return previous + 2;
+}
+
+} // namespace mgl_wrapper
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cmath>
+
+#include <mapbox/geometry/for_each_point.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/projection.hpp>
+#include <mbgl/util/rapidjson.hpp>
+
+#include "source_coverage.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+// Extend bounds to include a position
+void extendPosition(double lon, double lat, std::optional<Bounds> &bounds) {
+    if (!bounds) {
+        bounds = Bounds{lon, lat, lon, lat};
+    } else {
+        bounds->west  = std::min(bounds->west, lon);
+        bounds->south = std::min(bounds->south, lat);
+        bounds->east  = std::max(bounds->east, lon);
+        bounds->north = std::max(bounds->north, lat);
+    }
+}
+
+// Extend bounds to include the positions in a GeoJSON coordinates array,
+// which may be nested to any depth
+void extendCoordinates(const mbgl::JSValue &coordinates, std::optional<Bounds> &bounds) {
+    if (!coordinates.IsArray() || coordinates.Size() == 0) {
+        return;
+    }
+
+    if (coordinates[0].IsNumber()) {
+        if (coordinates.Size() < 2 || !coordinates[1].IsNumber()) {
+            return;
+        }
+        extendPosition(coordinates[0].GetDouble(), coordinates[1].GetDouble(), bounds);
+        return;
+    }
+
+    for (const auto &child : coordinates.GetArray()) {
+        extendCoordinates(child, bounds);
+    }
+}
+
+// Extend bounds to include a GeoJSON object of any type
+void extendGeoJSON(const mbgl::JSValue &value, std::optional<Bounds> &bounds) {
+    if (!value.IsObject()) {
+        return;
+    }
+    if (value.HasMember("coordinates")) {
+        extendCoordinates(value["coordinates"], bounds);
+    }
+    for (const char *member : {"geometry", "features", "geometries"}) {
+        if (!value.HasMember(member)) {
+            continue;
+        }
+        const mbgl::JSValue &child = value[member];
+        if (child.IsArray()) {
+            for (const auto &item : child.GetArray()) {
+                extendGeoJSON(item, bounds);
+            }
+        } else {
+            extendGeoJSON(child, bounds);
+        }
+    }
+}
+
+// Read the bounds of a TileJSON object, if it has valid bounds
+std::optional<Bounds> readTilesetBounds(const mbgl::JSValue &tileset) {
+    if (!tileset.HasMember("bounds") || !tileset["bounds"].IsArray()
+        || tileset["bounds"].Size() != 4) {
+        return std::nullopt;
+    }
+
+    const mbgl::JSValue &values = tileset["bounds"];
+    for (const auto &value : values.GetArray()) {
+        if (!value.IsNumber()) {
+            return std::nullopt;
+        }
+    }
+    return Bounds{values[0].GetDouble(),
+                  values[1].GetDouble(),
+                  values[2].GetDouble(),
+                  values[3].GetDouble()};
+}
+
+bool intersects(const Bounds &a, const Bounds &b) {
+    if (a.south > b.north || a.north < b.south) {
+        return false;
+    }
+    // tiles buffered beyond the antimeridian wrap around the world
+    for (double offset : {-360.0, 0.0, 360.0}) {
+        if (a.west + offset <= b.east && a.east + offset >= b.west) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void SourceCoverage::addSource(const std::string &id, const std::string &options) {
+    mbgl::JSDocument d;
+    d.Parse<0>(options.c_str(), options.length());
+
+    Coverage coverage;
+    if (!d.HasParseError() && d.IsObject() && d.HasMember("type") && d["type"].IsString()) {
+        const std::string type = d["type"].GetString();
+
+        if (type == "geojson" && d.HasMember("data")) {
+            const mbgl::JSValue &data = d["data"];
+            if (data.IsString()) {
+                coverage.url = data.GetString();
+            } else {
+                coverage.known = true;
+                extendGeoJSON(data, coverage.bounds);
+            }
+
+        } else if (type == "image" || type == "video") {
+            coverage.known = d.HasMember("coordinates");
+            if (coverage.known) {
+                extendCoordinates(d["coordinates"], coverage.bounds);
+            }
+
+        } else if (d.HasMember("url") && d["url"].IsString()) {
+            // tileset is loaded from url, e.g., from mbtiles metadata
+            coverage.url = d["url"].GetString();
+
+        } else {
+            coverage.bounds = readTilesetBounds(d);
+            coverage.known  = coverage.bounds.has_value();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    sources[id] = std::move(coverage);
+}
+
+void SourceCoverage::setGeoJSON(const std::string &id, const mapbox::geojson::geojson &geoJSON) {
+    auto bounds = geoJSONBounds(geoJSON);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Coverage &coverage = sources[id];
+    coverage.url.clear();
+    coverage.known  = true;
+    coverage.bounds = bounds;
+}
+
+void SourceCoverage::addResponse(const std::string &url, const std::string &data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool referenced = std::any_of(sources.begin(), sources.end(), [&](const auto &item) {
+            return item.second.url == url;
+        });
+        if (!referenced) {
+            return;
+        }
+    }
+
+    mbgl::JSDocument d;
+    d.Parse<0>(data.c_str(), data.length());
+    if (d.HasParseError() || !d.IsObject()) {
+        return;
+    }
+
+    // TileJSON has tiles, otherwise data is GeoJSON
+    std::optional<Bounds> bounds;
+    bool known = true;
+    if (d.HasMember("tiles")) {
+        bounds = readTilesetBounds(d);
+        known  = bounds.has_value();
+    } else {
+        extendGeoJSON(d, bounds);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &[id, coverage] : sources) {
+        if (coverage.url == url) {
+            coverage.known  = known;
+            coverage.bounds = bounds;
+        }
+    }
+}
+
+const std::optional<Bounds> SourceCoverage::getBounds(const std::string &id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto coverage = sources.find(id);
+    if (coverage == sources.end() || !coverage->second.known) {
+        return std::nullopt;
+    }
+    return coverage->second.bounds;
+}
+
+const bool SourceCoverage::tileHasData(const std::vector<std::string> &sourceIDs,
+                                       uint32_t z,
+                                       uint32_t x,
+                                       uint32_t y,
+                                       double buffer) {
+    const Bounds tile = tileBounds(z, x, y, buffer);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &id : sourceIDs) {
+        auto coverage = sources.find(id);
+        if (coverage == sources.end() || !coverage->second.known) {
+            return true;
+        }
+        if (coverage->second.bounds && intersects(tile, *coverage->second.bounds)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<Bounds> geoJSONBounds(const mapbox::geojson::geojson &geoJSON) {
+    std::optional<Bounds> bounds;
+    auto extendGeometry = [&](const mapbox::geojson::geometry &geometry) {
+        mapbox::geometry::for_each_point(geometry, [&](const mapbox::geojson::point &point) {
+            extendPosition(point.x, point.y, bounds);
+        });
+    };
+
+    geoJSON.match(
+        [&](const mapbox::geojson::geometry &geometry) { extendGeometry(geometry); },
+        [&](const mapbox::geojson::feature &feature) { extendGeometry(feature.geometry); },
+        [&](const mapbox::geojson::feature_collection &features) {
+            for (const auto &feature : features) {
+                extendGeometry(feature.geometry);
+            }
+        });
+    return bounds;
+}
+
+Bounds tileBounds(uint32_t z, uint32_t x, uint32_t y, double buffer) {
+    const double scale = std::pow(2.0, z);
+    auto unproject     = [scale](double tileX, double tileY) {
+        return mbgl::Projection::unproject(
+            {tileX * mbgl::util::tileSize_D, tileY * mbgl::util::tileSize_D}, scale);
+    };
+
+    const mbgl::LatLng northwest = unproject(x - buffer, y - buffer);
+    const mbgl::LatLng southeast = unproject(x + 1 + buffer, y + 1 + buffer);
+    return Bounds{northwest.longitude(),
+                  southeast.latitude(),
+                  southeast.longitude(),
+                  northwest.latitude()};
+}
+
+} // namespace mgl_wrapper
@@ -0,0 +1,238 @@
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <mbgl/style/conversion/json.hpp>
+#include <mbgl/style/conversion/layer.hpp>
+#include <mbgl/style/conversion/source.hpp>
+#include <mbgl/style/source.hpp>
+#include <mbgl/util/rapidjson.hpp>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "style.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+// arbitrary limit; large styles are ~300KB of JSON plus their parsed layers
+const size_t maxCachedStyles = 32;
+
+std::mutex cacheMutex;
+std::unordered_map<std::string, std::shared_ptr<StyleTemplate>> cache;
+std::deque<std::string> cacheOrder;
+
+std::string toJSON(const mbgl::JSValue &value) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    value.Accept(writer);
+    return buffer.GetString();
+}
+
+std::string describe(const StyleError &error) {
+    if (error.id.empty()) {
+        return error.message;
+    }
+    return error.type + " " + error.id + ": " + error.message;
+}
+
+// Convert the sources and layers of a parsed style using the same conversions
+// as loading a style into a map, recording all errors found.  Converted
+// sources (as JSON) and layers are returned if requested.
+void convertStyle(const mbgl::JSDocument &d,
+                  std::vector<StyleError> &errors,
+                  std::vector<std::pair<std::string, std::string>> *sources,
+                  std::vector<std::unique_ptr<mbgl::style::Layer>> *layers) {
+    using namespace mbgl::style;
+    using namespace mbgl::style::conversion;
+
+    if (!d.IsObject()) {
+        errors.push_back({"style", "", "style must be a JSON object"});
+        return;
+    }
+
+    if (!d.HasMember("version") || !d["version"].IsNumber() || d["version"].GetDouble() != 8) {
+        errors.push_back({"style", "", "style version must be 8"});
+    }
+
+    std::unordered_set<std::string> sourceIds;
+    if (d.HasMember("sources")) {
+        const mbgl::JSValue &value = d["sources"];
+        if (!value.IsObject()) {
+            errors.push_back({"style", "", "style sources must be an object"});
+        } else {
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                const std::string id = it->name.GetString();
+                sourceIds.insert(id);
+
+                Error error;
+                const mbgl::JSValue *sourceValue = &it->value;
+                if (!convert<std::unique_ptr<Source>>(sourceValue, error, id)) {
+                    errors.push_back({"source", id, error.message});
+                } else if (sources) {
+                    sources->emplace_back(id, toJSON(it->value));
+                }
+            }
+        }
+    }
+
+    if (d.HasMember("layers")) {
+        const mbgl::JSValue &value = d["layers"];
+        if (!value.IsArray()) {
+            errors.push_back({"style", "", "style layers must be an array"});
+            return;
+        }
+
+        std::unordered_set<std::string> layerIds;
+        for (rapidjson::SizeType i = 0; i < value.Size(); i++) {
+            const mbgl::JSValue &layerValue = value[i];
+            std::string id;
+            if (layerValue.IsObject() && layerValue.HasMember("id")
+                && layerValue["id"].IsString()) {
+                id = layerValue["id"].GetString();
+            }
+
+            Error error;
+            const mbgl::JSValue *layerPtr = &layerValue;
+            auto layer                    = convert<std::unique_ptr<Layer>>(layerPtr, error);
+            if (!layer) {
+                errors.push_back({"layer", id, error.message});
+                continue;
+            }
+
+            if (!layerIds.insert(id).second) {
+                errors.push_back({"layer", id, "duplicate layer id"});
+            }
+
+            const std::string sourceId = (*layer)->getSourceID();
+            if (!sourceId.empty() && !sourceIds.count(sourceId)) {
+                errors.push_back({"layer", id, "source " + sourceId + " is not in the style"});
+            }
+
+            if (layers) {
+                layers->push_back(std::move(*layer));
+            }
+        }
+    }
+}
+
+} // namespace
+
+const std::vector<StyleError> validateStyle(const std::string &style) {
+    std::vector<StyleError> errors;
+
+    mbgl::JSDocument d;
+    d.Parse<0>(style.c_str(), style.length());
+    if (d.HasParseError()) {
+        errors.push_back({"style", "", "error parsing style: " + mbgl::formatJSONParseError(d)});
+        return errors;
+    }
+
+    convertStyle(d, errors, nullptr, nullptr);
+    return errors;
+}
+
+StyleTemplate::StyleTemplate(const std::string &style) : json(style) {
+    mbgl::JSDocument d;
+    d.Parse<0>(style.c_str(), style.length());
+    if (d.HasParseError()) {
+        throw std::invalid_argument("error parsing style: " + mbgl::formatJSONParseError(d));
+    }
+
+    // the template is only created for a valid style
+    std::vector<StyleError> errors;
+    convertStyle(d, errors, &sources, &layers);
+    if (!errors.empty()) {
+        throw std::invalid_argument(describe(errors.front()));
+    }
+
+    d.RemoveMember("sources");
+    d.RemoveMember("layers");
+    d.AddMember("sources", mbgl::JSValue(rapidjson::kObjectType), d.GetAllocator());
+    d.AddMember("layers", mbgl::JSValue(rapidjson::kArrayType), d.GetAllocator());
+    skeleton = toJSON(d);
+}
+
+std::shared_ptr<StyleTemplate> StyleTemplate::get(const std::string &style) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = cache.find(style);
+        if (found != cache.end()) {
+            return found->second;
+        }
+    }
+
+    // parse outside the lock; if another thread parsed the same style in the
+    // meantime, its template is kept
+    auto styleTemplate = std::make_shared<StyleTemplate>(style);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto inserted = cache.emplace(style, styleTemplate);
+    if (inserted.second) {
+        cacheOrder.push_back(style);
+        if (cacheOrder.size() > maxCachedStyles) {
+            cache.erase(cacheOrder.front());
+            cacheOrder.pop_front();
+        }
+    }
+    return inserted.first->second;
+}
+
+void StyleTemplate::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+    cacheOrder.clear();
+}
+
+const size_t StyleTemplate::cacheSize() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return cache.size();
+}
+
+const std::string &StyleTemplate::getJSON() const { return json; }
+
+const std::vector<std::string> StyleTemplate::listLayers() const {
+    std::vector<std::string> layerIds;
+    layerIds.reserve(layers.size());
+    for (const auto &layer : layers) {
+        layerIds.push_back(layer->getID());
+    }
+    return layerIds;
+}
+
+const std::vector<std::string> StyleTemplate::listSources() const {
+    std::vector<std::string> sourceIds;
+    sourceIds.reserve(sources.size());
+    for (const auto &source : sources) {
+        sourceIds.push_back(source.first);
+    }
+    return sourceIds;
+}
+
+void StyleTemplate::instantiate(mbgl::style::Style &style) const {
+    using namespace mbgl::style;
+    using namespace mbgl::style::conversion;
+
+    // loads sprite, glyphs, and other top-level properties
+    style.loadJSON(skeleton);
+
+    for (const auto &source : sources) {
+        Error error;
+        auto converted = convertJSON<std::unique_ptr<Source>>(source.second, error, source.first);
+        if (!converted) {
+            throw std::invalid_argument("source " + source.first + ": " + error.message);
+        }
+        style.addSource(std::move(*converted));
+    }
+
+    // cloned layers share their immutable properties with this template
+    for (const auto &layer : layers) {
+        style.addLayer(layer->cloneRef(layer->getID()));
+    }
+}
+
+} // namespace mgl_wrapper
@@ -0,0 +1,11 @@
+#include "image_info.h"
+#include "tile_writer.h"
+
+namespace mgl_wrapper {
+
+void TileWriter::addTile(uint32_t z, uint32_t x, uint32_t y, const std::string &data) {
+    addTile(
+        z, x, y, data, xxhash64(reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+}
+
+} // namespace mgl_wrapper
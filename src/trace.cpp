@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <mbgl/util/logging.hpp>
+#include <mbgl/util/platform.hpp>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "trace.h"
+
+namespace mgl_wrapper {
+
+namespace {
+
+std::atomic<bool> enabled{false};
+std::atomic<uint32_t> nextThread{1};
+
+std::mutex traceMutex;
+std::vector<TraceEvent> buffer;
+// index of the next event to write and number of events retained
+size_t head  = 0;
+size_t count = 0;
+// names of threads that recorded events, by trace thread ID
+std::map<uint32_t, std::string> threadNames;
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Return a small, stable ID for the current thread; Chrome trace viewers
+// expect integer thread IDs
+uint32_t currentThread() {
+    thread_local uint32_t id = 0;
+    if (id == 0) {
+        id = nextThread++;
+
+        std::string name = mbgl::platform::getCurrentThreadName();
+        if (name.empty()) {
+            name = "thread " + std::to_string(id);
+        }
+        std::lock_guard<std::mutex> lock(traceMutex);
+        threadNames[id] = name;
+    }
+    return id;
+}
+
+void record(TraceEvent event) {
+    event.thread = currentThread();
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (buffer.empty()) {
+        return;
+    }
+    buffer[head] = std::move(event);
+    head         = (head + 1) % buffer.size();
+    if (count < buffer.size()) {
+        count++;
+    }
+}
+
+} // namespace
+
+namespace tracing {
+
+void start(size_t capacity) {
+    if (capacity == 0) {
+        throw std::domain_error("capacity must be greater than 0");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        buffer.clear();
+        buffer.resize(capacity);
+        head  = 0;
+        count = 0;
+    }
+
+    // log records are otherwise delivered on a separate thread, which would
+    // hide the thread that logged them
+    mbgl::Log::useLogThread(false);
+    enabled = true;
+}
+
+void stop() {
+    if (enabled.exchange(false)) {
+        mbgl::Log::useLogThread(true);
+    }
+}
+
+bool isEnabled() { return enabled; }
+
+double now() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch)
+        .count();
+}
+
+void complete(const std::string &name,
+              const std::string &category,
+              double timestamp,
+              double duration,
+              TraceArgs args) {
+    if (!enabled) {
+        return;
+    }
+    record({name, category, 'X', timestamp, duration, 0, std::move(args)});
+}
+
+void instant(const std::string &name, const std::string &category, TraceArgs args) {
+    if (!enabled) {
+        return;
+    }
+    record({name, category, 'i', now(), 0, 0, std::move(args)});
+}
+
+std::vector<TraceEvent> getEvents() {
+    std::lock_guard<std::mutex> lock(traceMutex);
+
+    std::vector<TraceEvent> events;
+    events.reserve(count);
+    const size_t first = (head + buffer.size() - count) % std::max(buffer.size(), size_t(1));
+    for (size_t i = 0; i < count; i++) {
+        events.push_back(buffer[(first + i) % buffer.size()]);
+    }
+    return events;
+}
+
+std::string toJSON() {
+    const std::vector<TraceEvent> events = getEvents();
+    const int pid                        = static_cast<int>(getpid());
+
+    rapidjson::StringBuffer out;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(out);
+
+    writer.StartObject();
+    writer.Key("displayTimeUnit");
+    writer.String("ms");
+    writer.Key("traceEvents");
+    writer.StartArray();
+
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        for (const auto &entry : threadNames) {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String("thread_name");
+            writer.Key("ph");
+            writer.String("M");
+            writer.Key("pid");
+            writer.Int(pid);
+            writer.Key("tid");
+            writer.Uint(entry.first);
+            writer.Key("args");
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(entry.second.c_str(), entry.second.size());
+            writer.EndObject();
+            writer.EndObject();
+        }
+    }
+
+    for (const auto &event : events) {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(event.name.c_str(), event.name.size());
+        writer.Key("cat");
+        writer.String(event.category.c_str(), event.category.size());
+        writer.Key("ph");
+        writer.String(&event.phase, 1);
+        writer.Key("ts");
+        writer.Double(event.timestamp);
+        if (event.phase == 'X') {
+            writer.Key("dur");
+            writer.Double(event.duration);
+        } else {
+            // scope instant events to their thread
+            writer.Key("s");
+            writer.String("t");
+        }
+        writer.Key("pid");
+        writer.Int(pid);
+        writer.Key("tid");
+        writer.Uint(event.thread);
+        if (!event.args.empty()) {
+            writer.Key("args");
+            writer.StartObject();
+            for (const auto &arg : event.args) {
+                writer.Key(arg.first.c_str());
+                writer.String(arg.second.c_str(), arg.second.size());
+            }
+            writer.EndObject();
+        }
+        writer.EndObject();
+    }
+
+    writer.EndArray();
+    writer.EndObject();
+
+    return out.GetString();
+}
+
+} // namespace tracing
+
+TraceSpan::TraceSpan(const std::string &name, const std::string &category, TraceArgs args)
+    : enabled(tracing::isEnabled()), start(0) {
+    if (enabled) {
+        this->name     = name;
+        this->category = category;
+        this->args     = std::move(args);
+        start          = tracing::now();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (enabled) {
+        tracing::complete(name, category, start, tracing::now() - start, std::move(args));
+    }
+}
+
+} // namespace mgl_wrapper
@@ -0,0 +1,115 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "frame_pipeline.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+mbgl::PremultipliedImage make_image(uint8_t value) {
+    mbgl::PremultipliedImage image({2, 2});
+    image.fill(value);
+    return image;
+}
+
+TEST(FramePipeline, ProcessesInOrder) {
+    vector<uint64_t> indexes;
+    vector<uint8_t> values;
+    FramePipeline pipeline([&](uint64_t index, mbgl::PremultipliedImage image) {
+        // slow processing must not change the order of frames
+        this_thread::sleep_for(chrono::milliseconds(index % 2 ? 5 : 0));
+        indexes.push_back(index);
+        values.push_back(image.data[0]);
+    });
+
+    for (uint8_t i = 0; i < 10; i++) {
+        pipeline.push(make_image(i));
+    }
+    pipeline.finish();
+
+    ASSERT_EQ(indexes.size(), 10);
+    for (uint8_t i = 0; i < 10; i++) {
+        EXPECT_EQ(indexes[i], i);
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+TEST(FramePipeline, LimitsQueuedFrames) {
+    atomic<bool> release{false};
+    atomic<uint32_t> processed{0};
+    FramePipeline pipeline(
+        [&](uint64_t, mbgl::PremultipliedImage) {
+            while (!release) {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            processed++;
+        },
+        1);
+
+    // one frame is being processed and one is queued, so the third push
+    // blocks until processing is released
+    pipeline.push(make_image(0));
+    pipeline.push(make_image(1));
+
+    atomic<bool> pushed{false};
+    thread producer([&]() {
+        pipeline.push(make_image(2));
+        pushed = true;
+    });
+
+    this_thread::sleep_for(chrono::milliseconds(50));
+    EXPECT_FALSE(pushed);
+
+    release = true;
+    producer.join();
+    EXPECT_TRUE(pushed);
+
+    pipeline.finish();
+    EXPECT_EQ(processed, 3);
+}
+
+TEST(FramePipeline, Errors) {
+    uint32_t calls = 0;
+    FramePipeline pipeline([&](uint64_t, mbgl::PremultipliedImage) {
+        calls++;
+        throw runtime_error("could not process frame");
+    });
+
+    pipeline.push(make_image(0));
+
+    // the error is raised by a later push or finish
+    EXPECT_THROW(
+        {
+            for (uint8_t i = 1; i < 10; i++) {
+                pipeline.push(make_image(i));
+            }
+            pipeline.finish();
+        },
+        runtime_error);
+    EXPECT_EQ(calls, 1);
+
+    EXPECT_THROW(FramePipeline([](uint64_t, mbgl::PremultipliedImage) {}, 0), domain_error);
+}
+
+TEST(FramePipeline, DiscardsOnDestroy) {
+    atomic<uint32_t> processed{0};
+    {
+        FramePipeline pipeline([&](uint64_t, mbgl::PremultipliedImage) {
+            this_thread::sleep_for(chrono::milliseconds(20));
+            processed++;
+        });
+        pipeline.push(make_image(0));
+        pipeline.push(make_image(1));
+        pipeline.push(make_image(2));
+    }
+
+    // frames still queued when the pipeline is destroyed are not processed
+    EXPECT_LT(processed, 3);
+}
@@ -0,0 +1,100 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "image_info.h"
+#include "spng.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+namespace {
+
+// Decode PNG bytes to unpremultiplied RGBA pixels
+vector<uint8_t> decodeRGBA(const string &png, uint32_t &width, uint32_t &height) {
+    spng_ctx *ctx = spng_ctx_new(0);
+    spng_set_png_buffer(ctx, png.data(), png.size());
+
+    struct spng_ihdr ihdr;
+    spng_get_ihdr(ctx, &ihdr);
+    width  = ihdr.width;
+    height = ihdr.height;
+
+    size_t size;
+    spng_decoded_image_size(ctx, SPNG_FMT_RGBA8, &size);
+    vector<uint8_t> out(size);
+    int ret = spng_decode_image(ctx, out.data(), size, SPNG_FMT_RGBA8, SPNG_DECODE_TRNS);
+    spng_ctx_free(ctx);
+    if (ret) {
+        out.clear();
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(ImageInfo, UniformColor) {
+    // not a multiple of the block size
+    const size_t pixels = 1000 + 5;
+    vector<uint8_t> data(pixels * 4);
+    for (size_t i = 0; i < pixels; i++) {
+        memcpy(data.data() + i * 4, "\x10\x20\x30\xff", 4);
+    }
+
+    auto color = uniformColor(data.data(), pixels);
+    ASSERT_TRUE(color.has_value());
+    EXPECT_EQ(*color, (Color{0x10, 0x20, 0x30, 0xff}));
+
+    // a different pixel in a block or in the remainder
+    data[500 * 4 + 3] = 0;
+    EXPECT_FALSE(uniformColor(data.data(), pixels).has_value());
+    data[500 * 4 + 3]      = 0xff;
+    data[(pixels - 1) * 4] = 0;
+    EXPECT_FALSE(uniformColor(data.data(), pixels).has_value());
+
+    EXPECT_TRUE(uniformColor(data.data(), 1).has_value());
+    EXPECT_FALSE(uniformColor(data.data(), 0).has_value());
+}
+
+TEST(ImageInfo, XXHash64) {
+    auto hash = [](const string &value) {
+        return xxhash64(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+    };
+
+    // reference values from the xxHash implementation
+    EXPECT_EQ(hash(""), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(hash("a"), 0xD24EC4F1A98C6E5BULL);
+    EXPECT_EQ(hash("abc"), 0x44BC2CF5AD770999ULL);
+
+    string bytes;
+    for (int i = 0; i < 3; i++) {
+        for (int c = 0; c < 256; c++) {
+            bytes.push_back(char(c));
+        }
+    }
+    bytes += "xyz";
+    EXPECT_EQ(hash(bytes), 0xE921A1B45BD779F8ULL);
+}
+
+TEST(ImageInfo, EncodeUniformPNG) {
+    for (const Color &color : {Color{0x10, 0x20, 0x30, 0xff}, Color{0xff, 0, 0, 0x80}}) {
+        const string png = encodeUniformPNG(257, 100, color);
+
+        uint32_t width, height;
+        auto pixels = decodeRGBA(png, width, height);
+        ASSERT_EQ(width, 257);
+        ASSERT_EQ(height, 100);
+        ASSERT_EQ(pixels.size(), 257 * 100 * 4);
+
+        auto decoded = uniformColor(pixels.data(), 257 * 100);
+        ASSERT_TRUE(decoded.has_value());
+        EXPECT_EQ(*decoded, color);
+
+        // far smaller than the RGBA pixels
+        EXPECT_LT(png.size(), 200);
+    }
+}
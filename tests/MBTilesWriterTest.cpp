@@ -0,0 +1,140 @@
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <mbgl/storage/sqlite3.hpp>
+
+#include "mbtiles_writer.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+namespace fs = std::filesystem;
+
+// Tests are named TEST(<group name>, <test name>)
+
+namespace {
+
+// Return the first column of the first row of a query, as a string
+string queryValue(const string &filename, const string &sql) {
+    auto db = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadOnly);
+    mapbox::sqlite::Statement stmt(db, sql.c_str());
+    mapbox::sqlite::Query query(stmt);
+    if (!query.run()) {
+        return "";
+    }
+    return query.get<string>(0);
+}
+
+} // namespace
+
+TEST(MBTilesWriter, AddTiles) {
+    const string filename = "/tmp/mbtiles_writer.mbtiles";
+    fs::remove(filename);
+
+    MBTilesWriter writer(filename, 2);
+    writer.setMetadata("name", "test");
+    writer.setMetadata("format", "png");
+    writer.addTile(0, 0, 0, "a");
+    writer.addTile(1, 0, 0, "b");
+    writer.addTile(1, 1, 0, "b");
+    writer.addTile(1, 0, 1, "a");
+    writer.addTile(1, 1, 1, "c", 1234);
+
+    EXPECT_THROW(writer.addTile(1, 2, 0, "a"), std::invalid_argument);
+    EXPECT_THROW(writer.addTile(1, 0, 2, "a"), std::invalid_argument);
+
+    EXPECT_EQ(writer.getTileCount(), 5);
+    EXPECT_EQ(writer.getImageCount(), 3);
+    writer.close();
+    EXPECT_THROW(writer.addTile(0, 0, 0, "a"), std::runtime_error);
+
+    EXPECT_EQ(queryValue(filename, "SELECT value FROM metadata WHERE name = 'name'"), "test");
+    EXPECT_EQ(queryValue(filename, "SELECT CAST(COUNT(*) AS TEXT) FROM tiles"), "5");
+    EXPECT_EQ(queryValue(filename, "SELECT CAST(COUNT(*) AS TEXT) FROM images"), "3");
+
+    // rows are flipped to the TMS scheme
+    EXPECT_EQ(queryValue(filename,
+                         "SELECT CAST(tile_data AS TEXT) FROM tiles "
+                         "WHERE zoom_level = 1 AND tile_column = 0 AND tile_row = 1"),
+              "b");
+    EXPECT_EQ(queryValue(filename, "SELECT tile_id FROM map WHERE zoom_level = 1 AND tile_row = 0 "
+                                   "AND tile_column = 1"),
+              "00000000000004d2");
+
+    fs::remove(filename);
+}
+
+TEST(MBTilesWriter, ReplaceTiles) {
+    const string filename = "/tmp/mbtiles_writer_replace.mbtiles";
+    fs::remove(filename);
+
+    {
+        MBTilesWriter writer(filename);
+        writer.addTile(0, 0, 0, "a");
+        writer.addTile(1, 0, 0, "a");
+        writer.addTile(1, 1, 0, "b");
+    }
+
+    // images already in the file are not counted again
+    MBTilesWriter writer(filename);
+    writer.addTile(1, 0, 0, "b");
+    writer.addTile(1, 1, 0, "c");
+    EXPECT_EQ(writer.getImageCount(), 1);
+    writer.close();
+
+    EXPECT_EQ(queryValue(filename, "SELECT CAST(COUNT(*) AS TEXT) FROM tiles"), "3");
+    EXPECT_EQ(queryValue(filename,
+                         "SELECT CAST(tile_data AS TEXT) FROM tiles "
+                         "WHERE zoom_level = 1 AND tile_column = 0 AND tile_row = 1"),
+              "b");
+
+    // images that are no longer referenced are deleted
+    EXPECT_EQ(queryValue(filename, "SELECT CAST(COUNT(*) AS TEXT) FROM images"), "3");
+
+    fs::remove(filename);
+}
+
+TEST(MBTilesWriter, HashCollision) {
+    const string filename = "/tmp/mbtiles_writer_collision.mbtiles";
+    fs::remove(filename);
+
+    // images with the same hash are only shared if their data is the same
+    MBTilesWriter writer(filename);
+    writer.addTile(1, 0, 0, "a", 1234);
+    writer.addTile(1, 1, 0, "b", 1234);
+    writer.addTile(1, 0, 1, "bb", 1234);
+    writer.addTile(1, 1, 1, "b", 1234);
+    EXPECT_EQ(writer.getImageCount(), 3);
+    writer.close();
+
+    EXPECT_EQ(queryValue(filename, "SELECT CAST(COUNT(*) AS TEXT) FROM images"), "3");
+    EXPECT_EQ(queryValue(filename,
+                         "SELECT CAST(tile_data AS TEXT) FROM tiles "
+                         "WHERE zoom_level = 1 AND tile_column = 1 AND tile_row = 1"),
+              "b");
+    EXPECT_EQ(queryValue(filename,
+                         "SELECT CAST(tile_data AS TEXT) FROM tiles "
+                         "WHERE zoom_level = 1 AND tile_column = 0 AND tile_row = 0"),
+              "bb");
+    EXPECT_EQ(queryValue(filename, "SELECT tile_id FROM map WHERE zoom_level = 1 AND tile_row = 0 "
+                                   "AND tile_column = 1"),
+              "00000000000004d2-1");
+
+    fs::remove(filename);
+}
+
+TEST(MBTilesWriter, InvalidFile) {
+    const string filename = "/tmp/mbtiles_writer_invalid.mbtiles";
+    fs::remove(filename);
+
+    {
+        auto db = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadWriteCreate);
+        db.exec("CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, "
+                "tile_data BLOB)");
+    }
+    EXPECT_THROW(MBTilesWriter{filename}, std::runtime_error);
+    EXPECT_THROW(MBTilesWriter(filename + ".new", 0), std::domain_error);
+
+    fs::remove(filename);
+}
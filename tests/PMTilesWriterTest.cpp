@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "pmtiles_writer.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+namespace fs = std::filesystem;
+
+// Tests are named TEST(<group name>, <test name>)
+
+namespace {
+
+struct Entry {
+    uint64_t tileID;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t runLength;
+};
+
+string readFile(const string &filename) {
+    ifstream in(filename, ios::binary);
+    stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+template <typename T>
+T readValue(const string &data, size_t offset) {
+    T value;
+    memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+string gunzip(const string &data) {
+    z_stream stream = {};
+    inflateInit2(&stream, 16 + MAX_WBITS);
+    stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = data.size();
+
+    string out;
+    char buffer[16384];
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        stream.next_out  = reinterpret_cast<Bytef *>(buffer);
+        stream.avail_out = sizeof(buffer);
+        ret              = inflate(&stream, Z_NO_FLUSH);
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+        throw runtime_error("invalid gzip data");
+    }
+    return out;
+}
+
+uint64_t readVarint(const string &data, size_t &pos) {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = data.at(pos++);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+vector<Entry> readDirectory(const string &compressed) {
+    const string data = gunzip(compressed);
+    size_t pos        = 0;
+
+    vector<Entry> entries(readVarint(data, pos));
+    uint64_t lastID = 0;
+    for (auto &entry : entries) {
+        entry.tileID = lastID + readVarint(data, pos);
+        lastID       = entry.tileID;
+    }
+    for (auto &entry : entries) {
+        entry.runLength = readVarint(data, pos);
+    }
+    for (auto &entry : entries) {
+        entry.length = readVarint(data, pos);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        const uint64_t value = readVarint(data, pos);
+        entries[i].offset
+            = value == 0 && i > 0 ? entries[i - 1].offset + entries[i - 1].length : value - 1;
+    }
+    return entries;
+}
+
+// Return the data of a tile in an archive, following leaf directories
+optional<string> getTile(const string &archive, uint32_t z, uint32_t x, uint32_t y) {
+    const uint64_t tileID = zxyToTileID(z, x, y);
+
+    uint64_t offset = readValue<uint64_t>(archive, 8);
+    uint64_t length = readValue<uint64_t>(archive, 16);
+    for (int depth = 0; depth < 4; depth++) {
+        const auto entries = readDirectory(archive.substr(offset, length));
+        auto found = upper_bound(entries.begin(), entries.end(), tileID, [](uint64_t id, auto &e) {
+            return id < e.tileID;
+        });
+        if (found == entries.begin()) {
+            return nullopt;
+        }
+        const Entry &entry = *(found - 1);
+
+        if (entry.runLength > 0) {
+            if (tileID >= entry.tileID + entry.runLength) {
+                return nullopt;
+            }
+            return archive.substr(readValue<uint64_t>(archive, 56) + entry.offset, entry.length);
+        }
+        offset = readValue<uint64_t>(archive, 40) + entry.offset;
+        length = entry.length;
+    }
+    return nullopt;
+}
+
+} // namespace
+
+TEST(PMTilesWriter, TileID) {
+    // reference values from the PMTiles specification
+    EXPECT_EQ(zxyToTileID(0, 0, 0), 0);
+    EXPECT_EQ(zxyToTileID(1, 0, 0), 1);
+    EXPECT_EQ(zxyToTileID(1, 0, 1), 2);
+    EXPECT_EQ(zxyToTileID(1, 1, 1), 3);
+    EXPECT_EQ(zxyToTileID(1, 1, 0), 4);
+    EXPECT_EQ(zxyToTileID(2, 0, 0), 5);
+    EXPECT_EQ(zxyToTileID(12, 3423, 1763), 19078479);
+}
+
+TEST(PMTilesWriter, AddTiles) {
+    const string filename = "/tmp/pmtiles_writer.pmtiles";
+    const string png      = string("\x89PNG\r\n\x1a\n", 8);
+
+    PMTilesWriter writer(filename);
+    writer.setMetadata("name", "test \"tiles\"");
+
+    // out of order, with repeated images and a replaced tile
+    writer.addTile(2, 1, 1, png + "b");
+    writer.addTile(1, 0, 0, png + "a");
+    writer.addTile(1, 0, 1, png + "a");
+    writer.addTile(1, 1, 1, png + "a");
+    writer.addTile(0, 0, 0, png + "c");
+    writer.addTile(2, 1, 1, png + "d");
+    writer.addTile(2, 3, 3, png + "x", 1234);
+
+    EXPECT_THROW(writer.addTile(1, 2, 0, "a"), std::invalid_argument);
+    EXPECT_EQ(writer.getTileCount(), 7);
+    EXPECT_EQ(writer.getImageCount(), 5);
+    writer.close();
+    EXPECT_THROW(writer.addTile(0, 0, 0, "a"), std::runtime_error);
+
+    const string archive = readFile(filename);
+    fs::remove(filename);
+    ASSERT_GT(archive.size(), 127);
+    EXPECT_EQ(archive.substr(0, 7), "PMTiles");
+    EXPECT_EQ(archive[7], 3);
+
+    EXPECT_EQ(getTile(archive, 0, 0, 0), png + "c");
+    EXPECT_EQ(getTile(archive, 1, 0, 0), png + "a");
+    EXPECT_EQ(getTile(archive, 1, 1, 1), png + "a");
+    EXPECT_EQ(getTile(archive, 2, 1, 1), png + "d");
+    EXPECT_EQ(getTile(archive, 2, 3, 3), png + "x");
+    EXPECT_FALSE(getTile(archive, 1, 1, 0).has_value());
+    EXPECT_FALSE(getTile(archive, 2, 0, 0).has_value());
+
+    // addressed tiles, entries (1/0/0 - 1/1/1 are one run), and contents;
+    // the replaced image is not written
+    EXPECT_EQ(readValue<uint64_t>(archive, 72), 6);
+    EXPECT_EQ(readValue<uint64_t>(archive, 80), 4);
+    EXPECT_EQ(readValue<uint64_t>(archive, 88), 4);
+    EXPECT_EQ(readValue<uint64_t>(archive, 64), 4 * 9);
+
+    // clustered, gzip directories, uncompressed PNG tiles
+    EXPECT_EQ(archive[96], 1);
+    EXPECT_EQ(archive[97], 2);
+    EXPECT_EQ(archive[98], 1);
+    EXPECT_EQ(archive[99], 2);
+    EXPECT_EQ(archive[100], 0);
+    EXPECT_EQ(archive[101], 2);
+    EXPECT_EQ(readValue<int32_t>(archive, 102), -1800000000);
+    EXPECT_EQ(readValue<int32_t>(archive, 110), 1800000000);
+    EXPECT_NEAR(readValue<int32_t>(archive, 114) / 1e7, 85.0511, 1e-4);
+
+    const string metadata = gunzip(
+        archive.substr(readValue<uint64_t>(archive, 24), readValue<uint64_t>(archive, 32)));
+    EXPECT_EQ(metadata, R"({"name":"test \"tiles\""})");
+}
+
+TEST(PMTilesWriter, HashCollision) {
+    const string filename = "/tmp/pmtiles_writer_collision.pmtiles";
+    const string png      = string("\x89PNG\r\n\x1a\n", 8);
+
+    // images with the same hash are only shared if their data is the same
+    PMTilesWriter writer(filename);
+    writer.addTile(1, 0, 0, png + "a", 1234);
+    writer.addTile(1, 1, 0, png + "b", 1234);
+    writer.addTile(1, 0, 1, png + "bb", 1234);
+    writer.addTile(1, 1, 1, png + "b", 1234);
+    EXPECT_EQ(writer.getImageCount(), 3);
+    writer.close();
+
+    const string archive = readFile(filename);
+    fs::remove(filename);
+    EXPECT_EQ(getTile(archive, 1, 0, 0), png + "a");
+    EXPECT_EQ(getTile(archive, 1, 1, 0), png + "b");
+    EXPECT_EQ(getTile(archive, 1, 0, 1), png + "bb");
+    EXPECT_EQ(getTile(archive, 1, 1, 1), png + "b");
+    EXPECT_EQ(readValue<uint64_t>(archive, 88), 3);
+}
+
+TEST(PMTilesWriter, LeafDirectories) {
+    const string filename = "/tmp/pmtiles_writer_leaves.pmtiles";
+
+    // sparse tiles with distinct images do not fit in the root directory
+    PMTilesWriter writer(filename);
+    const uint32_t count = 60000;
+    for (uint32_t i = 0; i < count; i++) {
+        writer.addTile(16, (i * 7919) % 65536, (i * 104729) % 65536, to_string(i));
+    }
+    writer.close();
+
+    const string archive = readFile(filename);
+    fs::remove(filename);
+    EXPECT_LE(readValue<uint64_t>(archive, 8) + readValue<uint64_t>(archive, 16), 16384);
+    EXPECT_GT(readValue<uint64_t>(archive, 48), 0);
+    EXPECT_EQ(readValue<uint64_t>(archive, 80), count);
+
+    for (uint32_t i = 0; i < count; i += 4999) {
+        EXPECT_EQ(getTile(archive, 16, (i * 7919) % 65536, (i * 104729) % 65536), to_string(i));
+    }
+}
+
+TEST(PMTilesWriter, InvalidFile) {
+    EXPECT_THROW(PMTilesWriter("/invalid/tiles.pmtiles"), std::runtime_error);
+}
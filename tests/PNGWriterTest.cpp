@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <mbgl/util/image.hpp>
+#include <mbgl/util/premultiply.hpp>
+
+#include "map.h"
+#include "png_writer.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+TEST(PNGWriter, WriteRows) {
+    const uint32_t width = 300, height = 257;
+
+    mbgl::UnassociatedImage image({width, height});
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t *pixel = image.data.get() + (y * width + x) * 4;
+            pixel[0]       = x % 256;
+            pixel[1]       = y % 256;
+            pixel[2]       = 128;
+            pixel[3]       = 255;
+        }
+    }
+
+    string out;
+    PNGWriter writer(width, height, [&](const uint8_t *data, size_t size) {
+        out.append(reinterpret_cast<const char *>(data), size);
+    });
+
+    // write in bands of rows that do not evenly divide the image
+    for (uint32_t y = 0; y < height; y += 100) {
+        EXPECT_FALSE(writer.isComplete());
+        writer.writeRows(image.data.get() + y * width * 4, min(100u, height - y));
+    }
+    EXPECT_TRUE(writer.isComplete());
+
+    // decodes to the same image as encoding all at once
+    auto decoded  = mbgl::util::unpremultiply(mbgl::decodeImage(out));
+    auto expected = mbgl::util::unpremultiply(mbgl::decodeImage(encodePNG(image)));
+    ASSERT_EQ(decoded.size, expected.size);
+    EXPECT_EQ(memcmp(decoded.data.get(), expected.data.get(), decoded.bytes()), 0);
+
+    EXPECT_THROW(writer.writeRows(image.data.get(), 1), std::invalid_argument);
+}
+
+TEST(PNGWriter, WriteErrors) {
+    const vector<uint8_t> row(4 * 4, 255);
+    EXPECT_THROW(
+        {
+            PNGWriter writer(4, 4, [](const uint8_t *, size_t) {
+                throw std::runtime_error("could not write");
+            });
+            for (uint32_t i = 0; i < 4; i++) {
+                writer.writeRows(row.data(), 1);
+            }
+        },
+        std::runtime_error);
+}
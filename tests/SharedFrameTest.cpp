@@ -0,0 +1,147 @@
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <mbgl/util/image.hpp>
+
+#include "shared_frame.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+namespace {
+
+// Map the named segment read-only, returning its size
+const uint8_t *mapSegment(const string &name, size_t &size) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    fstat(fd, &info);
+    size       = info.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return data == MAP_FAILED ? nullptr : static_cast<const uint8_t *>(data);
+}
+
+mbgl::UnassociatedImage makeImage(uint32_t width, uint32_t height, uint8_t value) {
+    mbgl::UnassociatedImage image({width, height});
+    memset(image.data.get(), value, image.bytes());
+    return image;
+}
+
+} // namespace
+
+TEST(SharedFrame, Write) {
+    const string name = "/pymgl-shared-frame-test";
+    shm_unlink(name.c_str());
+
+    auto image = makeImage(30, 20, 7);
+    EXPECT_EQ(writeSharedFrame(name, image, 2), 2);
+
+    size_t size;
+    const uint8_t *data = mapSegment(name, size);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(size, sizeof(SharedFrameHeader) + 30 * 20 * 4);
+
+    auto header = reinterpret_cast<const SharedFrameHeader *>(data);
+    EXPECT_EQ(string(header->magic, 4), "MGLF");
+    EXPECT_EQ(header->version, 1);
+    EXPECT_EQ(header->width, 30);
+    EXPECT_EQ(header->height, 20);
+    EXPECT_EQ(header->stride, 30 * 4);
+    EXPECT_EQ(header->format, 0);
+    EXPECT_EQ(header->dataOffset, 64);
+    EXPECT_EQ(header->sequence, 2);
+    EXPECT_EQ(header->pixelRatio, 2);
+    EXPECT_EQ(memcmp(data + header->dataOffset, image.data.get(), image.bytes()), 0);
+
+    // the mapping stays valid and sees later frames of the same size
+    image = makeImage(30, 20, 9);
+    EXPECT_EQ(writeSharedFrame(name, image, 2), 4);
+    EXPECT_EQ(header->sequence, 4);
+    EXPECT_EQ(data[header->dataOffset], 9);
+    munmap(const_cast<uint8_t *>(data), size);
+
+    // omitting the leading '/' refers to the same segment
+    EXPECT_EQ(writeSharedFrame("pymgl-shared-frame-test", image, 2), 6);
+
+    // a different size replaces the segment, restarting the sequence
+    image = makeImage(10, 5, 3);
+    EXPECT_EQ(writeSharedFrame(name, image, 1), 2);
+    data = mapSegment(name, size);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(size, sizeof(SharedFrameHeader) + 10 * 5 * 4);
+    header = reinterpret_cast<const SharedFrameHeader *>(data);
+    EXPECT_EQ(header->width, 10);
+    EXPECT_EQ(header->height, 5);
+    munmap(const_cast<uint8_t *>(data), size);
+
+    shm_unlink(name.c_str());
+}
+
+TEST(SharedFrame, ConcurrentRead) {
+    const string name = "/pymgl-shared-frame-concurrent-test";
+    shm_unlink(name.c_str());
+
+    // every pixel of frame i is i % 256, so a torn frame has mixed values
+    const uint32_t width = 256, height = 256;
+    writeSharedFrame(name, makeImage(width, height, 0), 1);
+
+    size_t size;
+    const uint8_t *data = mapSegment(name, size);
+    ASSERT_NE(data, nullptr);
+
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 1; i <= 200; i++) {
+            writeSharedFrame(name, makeImage(width, height, i % 256), 1);
+        }
+        done = true;
+    });
+
+    // read as documented in shared_frame.h
+    auto header = reinterpret_cast<const SharedFrameHeader *>(data);
+    std::atomic_ref<uint64_t> sequence(const_cast<uint64_t &>(header->sequence));
+    vector<uint8_t> pixels(size_t(width) * height * 4);
+    uint64_t accepted = 0;
+    while (!done || accepted == 0) {
+        const uint64_t before = sequence.load(std::memory_order_acquire);
+        memcpy(pixels.data(), data + sizeof(SharedFrameHeader), pixels.size());
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = sequence.load(std::memory_order_relaxed);
+        if (before % 2 == 1 || before != after) {
+            continue;
+        }
+
+        accepted++;
+        for (const uint8_t value : pixels) {
+            if (value != pixels[0]) {
+                ADD_FAILURE() << "torn frame at sequence " << before;
+                break;
+            }
+        }
+    }
+
+    writer.join();
+    munmap(const_cast<uint8_t *>(data), size);
+    shm_unlink(name.c_str());
+}
+
+TEST(SharedFrame, InvalidName) {
+    auto image = makeImage(1, 1, 0);
+    EXPECT_THROW(writeSharedFrame("", image, 1), std::invalid_argument);
+    EXPECT_THROW(writeSharedFrame("pymgl/frame", image, 1), std::invalid_argument);
+}
@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "source_coverage.h"
+
+using namespace mgl_wrapper;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+TEST(SourceCoverage, GeoJSONBounds) {
+    auto bounds = geoJSONBounds(mapbox::geojson::parse(R"({
+        "type": "FeatureCollection",
+        "features": [
+            {"type": "Feature", "geometry": {"type": "Point", "coordinates": [-120, 40]}},
+            {"type": "Feature", "geometry": null},
+            {"type": "Feature", "geometry": {
+                "type": "GeometryCollection",
+                "geometries": [
+                    {"type": "LineString", "coordinates": [[-110, 35], [-100, 45, 100]]}
+                ]
+            }}
+        ]
+    })"));
+    ASSERT_TRUE(bounds.has_value());
+    EXPECT_EQ(bounds->west, -120);
+    EXPECT_EQ(bounds->south, 35);
+    EXPECT_EQ(bounds->east, -100);
+    EXPECT_EQ(bounds->north, 45);
+
+    const auto point = mapbox::geojson::parse(R"({"type": "Point", "coordinates": [10, 20]})");
+    bounds           = geoJSONBounds(point);
+    ASSERT_TRUE(bounds.has_value());
+    EXPECT_EQ(bounds->west, 10);
+    EXPECT_EQ(bounds->north, 20);
+
+    const auto empty = mapbox::geojson::parse(R"({"type": "FeatureCollection", "features": []})");
+    EXPECT_FALSE(geoJSONBounds(empty).has_value());
+}
+
+TEST(SourceCoverage, TileBounds) {
+    auto world = tileBounds(0, 0, 0);
+    EXPECT_NEAR(world.west, -180, 1e-9);
+    EXPECT_NEAR(world.east, 180, 1e-9);
+    EXPECT_NEAR(world.north, 85.0511, 1e-4);
+    EXPECT_NEAR(world.south, -85.0511, 1e-4);
+
+    auto tile = tileBounds(1, 1, 0);
+    EXPECT_NEAR(tile.west, 0, 1e-9);
+    EXPECT_NEAR(tile.south, 0, 1e-9);
+
+    // buffer is a fraction of the width of the tile
+    auto buffered = tileBounds(1, 1, 0, 0.5);
+    EXPECT_NEAR(buffered.west, -90, 1e-9);
+    EXPECT_NEAR(buffered.east, 270, 1e-9);
+}
+
+TEST(SourceCoverage, TileHasData) {
+    SourceCoverage coverage;
+    coverage.addSource("geojson", R"({
+        "type": "geojson",
+        "data": {"type": "Point", "coordinates": [-120, 40]}
+    })");
+    coverage.addSource("empty", R"({
+        "type": "geojson",
+        "data": {"type": "FeatureCollection", "features": []}
+    })");
+    coverage.addSource("tiles", R"({
+        "type": "vector",
+        "tiles": ["http://test/{z}/{x}/{y}.pbf"],
+        "bounds": [10, 10, 20, 20]
+    })");
+
+    ASSERT_TRUE(coverage.getBounds("geojson").has_value());
+    EXPECT_EQ(coverage.getBounds("geojson")->west, -120);
+    EXPECT_FALSE(coverage.getBounds("empty").has_value());
+    EXPECT_EQ(coverage.getBounds("tiles")->east, 20);
+
+    EXPECT_TRUE(coverage.tileHasData({"geojson"}, 4, 2, 6, 0));
+    EXPECT_FALSE(coverage.tileHasData({"geojson"}, 4, 10, 6, 0));
+    EXPECT_FALSE(coverage.tileHasData({"geojson", "empty"}, 4, 10, 6, 0));
+    EXPECT_TRUE(coverage.tileHasData({"geojson", "tiles"}, 4, 8, 7, 0));
+
+    // a point on the edge of a neighboring tile is included by buffer
+    EXPECT_FALSE(coverage.tileHasData({"geojson"}, 4, 3, 6, 0));
+    EXPECT_TRUE(coverage.tileHasData({"geojson"}, 4, 3, 6, 0.5));
+
+    // data set directly replaces the data of the style
+    coverage.setGeoJSON("geojson",
+                        mapbox::geojson::parse(R"({"type": "Point", "coordinates": [100, 40]})"));
+    EXPECT_FALSE(coverage.tileHasData({"geojson"}, 4, 2, 6, 0));
+
+    // sources that are not known are assumed to have data everywhere
+    EXPECT_TRUE(coverage.tileHasData({"other"}, 4, 10, 6, 0));
+}
+
+TEST(SourceCoverage, Responses) {
+    SourceCoverage coverage;
+    coverage.addSource("tileset", R"({"type": "vector", "url": "mbtiles://land.mbtiles"})");
+    coverage.addSource("data", R"({"type": "geojson", "data": "http://test/data.geojson"})");
+
+    // not known until loaded
+    EXPECT_FALSE(coverage.getBounds("tileset").has_value());
+    EXPECT_TRUE(coverage.tileHasData({"tileset"}, 4, 10, 6, 0));
+
+    coverage.addResponse("mbtiles://land.mbtiles",
+                         R"({"tiles": ["mbtiles://land.mbtiles?{z}/{x}/{y}"],
+                             "bounds": [-10, -10, 10, 10]})");
+    ASSERT_TRUE(coverage.getBounds("tileset").has_value());
+    EXPECT_EQ(coverage.getBounds("tileset")->north, 10);
+    EXPECT_FALSE(coverage.tileHasData({"tileset"}, 4, 2, 6, 0));
+
+    coverage.addResponse("http://test/data.geojson",
+                         R"({"type": "Point", "coordinates": [-120, 40]})");
+    EXPECT_EQ(coverage.getBounds("data")->west, -120);
+
+    // responses for other resources are ignored
+    coverage.addResponse("http://test/other.geojson",
+                         R"({"type": "Point", "coordinates": [0, 0]})");
+    EXPECT_EQ(coverage.getBounds("data")->west, -120);
+}
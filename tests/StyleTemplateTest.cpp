@@ -0,0 +1,76 @@
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "map.h"
+#include "style.h"
+#include "util.h"
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+TEST(StyleTemplate, Construct) {
+    auto style = make_shared<StyleTemplate>(read_style("example-style-geojson.json"));
+
+    auto layers = style->listLayers();
+    EXPECT_EQ(layers.size(), 2);
+    EXPECT_EQ(layers[0], "box");
+    EXPECT_EQ(layers[1], "box-outline");
+
+    auto sources = style->listSources();
+    EXPECT_EQ(sources.size(), 1);
+    EXPECT_EQ(sources[0], "geojson");
+}
+
+TEST(StyleTemplate, Invalid) {
+    EXPECT_THROW(StyleTemplate("{"), std::invalid_argument);
+    EXPECT_THROW(StyleTemplate("[]"), std::invalid_argument);
+    EXPECT_THROW(StyleTemplate(R"({"version": 8, "sources": [], "layers": []})"),
+                 std::invalid_argument);
+    EXPECT_THROW(StyleTemplate(R"({
+        "version": 8,
+        "sources": {},
+        "layers": [{"id": "invalid", "type": "invalid"}]
+    })"),
+                 std::invalid_argument);
+}
+
+TEST(StyleTemplate, Map) {
+    auto style = make_shared<StyleTemplate>(read_style("example-style-geojson.json"));
+
+    Map map = Map(style, 10, 20);
+    EXPECT_EQ(map.getSize().first, 10);
+    EXPECT_EQ(map.getSize().second, 20);
+    EXPECT_EQ(map.listLayers(), style->listLayers());
+    EXPECT_EQ(map.listSources(), style->listSources());
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.5");
+
+    // modifying one map does not modify the template or other maps
+    map.setPaintProperty("box", "fill-opacity", "0.75");
+    Map map2 = Map(style, 10, 10);
+    EXPECT_EQ(map2.getPaintProperty("box", "fill-opacity").value(), "0.5");
+
+    map.renderPNG();
+    map2.renderPNG();
+}
+
+TEST(StyleTemplate, Cache) {
+    StyleTemplate::clearCache();
+    EXPECT_EQ(StyleTemplate::cacheSize(), 0);
+
+    const string style = read_style("example-style-geojson.json");
+    auto first         = StyleTemplate::get(style);
+    auto second        = StyleTemplate::get(style);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(StyleTemplate::cacheSize(), 1);
+
+    StyleTemplate::get(read_style("example-style-empty.json"));
+    EXPECT_EQ(StyleTemplate::cacheSize(), 2);
+
+    StyleTemplate::clearCache();
+    EXPECT_EQ(StyleTemplate::cacheSize(), 0);
+}
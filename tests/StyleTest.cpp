@@ -430,4 +430,71 @@ TEST(Style, AddGeoJSONPointLayer) {
 
     write_test_image(img, img_filename, false);
     EXPECT_TRUE(image_matches(img_filename, 10));
-}
\ No newline at end of file
+}
+TEST(Style, SetStyleDiff) {
+    const string test = "example-style-geojson-hidden-box";
+
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100, 1);
+    map.setBounds(-125, 37.5, -115, 42.5);
+    map.renderPNG();
+
+    map.setStyle(read_style(test + ".json"));
+    map.setVisibility("box", false);
+    map.setVisibility("box2", true);
+
+    auto img = map.renderPNG();
+
+    const string img_filename = test + ".png";
+    write_test_image(img, img_filename, false);
+    EXPECT_TRUE(image_matches(img_filename, 10));
+}
+
+TEST(Style, StyleTemplate) {
+    const string test = "example-style-geojson";
+    auto style        = StyleTemplate::get(read_style(test + ".json"));
+
+    Map map = Map(style, 100, 100, 1);
+    map.setBounds(-125, 37.5, -115, 42.5);
+    auto img = map.renderPNG();
+
+    const string img_filename = test + ".png";
+    write_test_image(img, img_filename, false);
+    EXPECT_TRUE(image_matches(img_filename, 10));
+}
+
+TEST(Style, SourceStats) {
+    string style = read_style("example-style-file-geojson.json");
+    style        = regex_replace(style, regex("file://"), "file://" + FIXTURES_PATH);
+
+    Map map = Map(style, 100, 100, 1);
+    map.setBounds(-125, 37.5, -115, 42.5);
+
+    auto stats = map.getSourceStats();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats[0].first, "geojson");
+    EXPECT_EQ(stats[0].second.requests, 0);
+
+    map.renderPNG();
+    stats = map.getSourceStats();
+    EXPECT_EQ(stats[0].second.requests, 1);
+    EXPECT_EQ(stats[0].second.tiles, 0);
+    EXPECT_GT(stats[0].second.bytes, 0);
+    EXPECT_EQ(stats[0].second.errors, 0);
+}
+
+TEST(Style, MBTilesSourceStats) {
+    string style = read_style("example-style-mbtiles-vector-source.json");
+    style        = regex_replace(style, regex("mbtiles://"), "mbtiles://" + FIXTURES_PATH);
+
+    Map map = Map(style, 256, 256, 1);
+    map.renderPNG();
+
+    auto stats = map.getSourceStats();
+    ASSERT_EQ(stats.size(), 1);
+
+    // tileset and tiles
+    EXPECT_GT(stats[0].second.requests, 1);
+    EXPECT_GT(stats[0].second.tiles, 0);
+    EXPECT_GT(stats[0].second.bytes, 0);
+    EXPECT_GT(stats[0].second.loadTime, 0);
+}
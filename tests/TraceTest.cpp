@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "map.h"
+#include "trace.h"
+#include "util.h"
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+bool has_event(const vector<TraceEvent> &events, const string &name) {
+    return any_of(
+        events.begin(), events.end(), [&](const TraceEvent &e) { return e.name == name; });
+}
+
+TEST(Trace, Disabled) {
+    tracing::stop();
+    tracing::start(10);
+    tracing::stop();
+
+    tracing::instant("ignored", "test");
+    { TraceSpan span("ignored", "test"); }
+
+    EXPECT_EQ(tracing::getEvents().size(), 0);
+}
+
+TEST(Trace, RingBuffer) {
+    tracing::start(3);
+    for (int i = 0; i < 5; i++) {
+        tracing::instant("event" + to_string(i), "test");
+    }
+    tracing::stop();
+
+    auto events = tracing::getEvents();
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].name, "event2");
+    EXPECT_EQ(events[2].name, "event4");
+}
+
+TEST(Trace, Threads) {
+    tracing::start(10);
+    { TraceSpan span("main", "test"); }
+    thread([]() { TraceSpan span("worker", "test"); }).join();
+    tracing::stop();
+
+    auto events = tracing::getEvents();
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(events[0].phase, 'X');
+    EXPECT_GE(events[0].duration, 0);
+    EXPECT_NE(events[0].thread, events[1].thread);
+}
+
+TEST(Trace, Render) {
+    tracing::start();
+    {
+        Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+        map.renderPNG();
+    }
+    tracing::stop();
+
+    auto events = tracing::getEvents();
+    for (const auto &name : {"Map", "loadStyle", "renderPNG", "draw", "encode"}) {
+        EXPECT_TRUE(has_event(events, name)) << name;
+    }
+
+    auto json = tracing::toJSON();
+    EXPECT_NE(json.find("\"traceEvents\""), string::npos);
+    EXPECT_NE(json.find("\"thread_name\""), string::npos);
+    EXPECT_NE(json.find("\"name\":\"renderPNG\""), string::npos);
+}
@@ -0,0 +1,59 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "style.h"
+#include "util.h"
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+// Tests are named TEST(<group name>, <test name>)
+
+TEST(ValidateStyle, Valid) {
+    EXPECT_EQ(validateStyle(read_style("example-style-empty.json")).size(), 0);
+    EXPECT_EQ(validateStyle(read_style("example-style-geojson.json")).size(), 0);
+    EXPECT_EQ(validateStyle(read_style("example-style-mbtiles-vector-source.json")).size(), 0);
+}
+
+TEST(ValidateStyle, InvalidJSON) {
+    auto errors = validateStyle("{");
+    EXPECT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0].type, "style");
+    EXPECT_EQ(errors[0].message.find("error parsing style"), 0);
+
+    errors = validateStyle("[]");
+    EXPECT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0].message, "style must be a JSON object");
+}
+
+TEST(ValidateStyle, InvalidStyle) {
+    auto errors = validateStyle(R"({
+        "version": 7,
+        "sources": {
+            "geojson": {"type": "geojson", "data": {"type": "Point", "coordinates": [0, 0]}},
+            "invalid": {"type": "invalid"}
+        },
+        "layers": [
+            {"id": "fill", "type": "fill", "source": "geojson", "paint": {"fill-color": 1}},
+            {"id": "filter", "type": "fill", "source": "geojson", "filter": ["invalid"]},
+            {"id": "missing", "type": "fill", "source": "missing"},
+            {"id": "circle", "type": "circle", "source": "geojson"},
+            {"id": "circle", "type": "circle", "source": "geojson"}
+        ]
+    })");
+
+    EXPECT_EQ(errors.size(), 6);
+    EXPECT_EQ(errors[0].type, "style");
+    EXPECT_EQ(errors[0].message, "style version must be 8");
+    EXPECT_EQ(errors[1].type, "source");
+    EXPECT_EQ(errors[1].id, "invalid");
+    EXPECT_EQ(errors[2].type, "layer");
+    EXPECT_EQ(errors[2].id, "fill");
+    EXPECT_EQ(errors[3].id, "filter");
+    EXPECT_EQ(errors[4].id, "missing");
+    EXPECT_EQ(errors[4].message, "source missing is not in the style");
+    EXPECT_EQ(errors[5].id, "circle");
+    EXPECT_EQ(errors[5].message, "duplicate layer id");
+}
@@ -1,11 +1,27 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <regex>
 #include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
+#include <mapbox/pixelmatch.hpp>
 #include <mbgl/util/rapidjson.hpp>
 
 #include "map.h"
+#include "mbtiles_writer.h"
+#include "pmtiles_writer.h"
+#include "shared_frame.h"
 #include "util.h"
 
 using namespace mgl_wrapper;
@@ -499,4 +515,770 @@ TEST(Wrapper, FeatureState) {
 
     EXPECT_THROW(map.removeFeatureState("invalid-source", "box", "0", "a"), std::runtime_error);
     EXPECT_THROW(map.removeFeatureState("geojson", "invalid-layer", "0", "a"), std::runtime_error);
-}
\ No newline at end of file
+}
+
+TEST(Wrapper, StyleBatch) {
+    Map map = Map(read_style("example-style-geojson.json"), 10, 10);
+
+    map.beginBatch();
+    EXPECT_TRUE(map.isBatching());
+    EXPECT_THROW(map.beginBatch(), std::runtime_error);
+
+    map.setPaintProperty("box", "fill-opacity", "0.75");
+    map.setVisibility("box", false);
+    map.addLayer(R"({
+        "id": "points",
+        "source": "geojson",
+        "type": "circle"
+    })");
+    map.setFilter("points", R"(["==", "foo", "bar"])");
+
+    // nothing is applied until the batch is committed
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.5");
+    EXPECT_EQ(map.getVisibility("box"), true);
+    EXPECT_EQ(map.listLayers().size(), 2);
+
+    map.commitBatch();
+    EXPECT_FALSE(map.isBatching());
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.75");
+    EXPECT_EQ(map.getVisibility("box"), false);
+    EXPECT_EQ(map.listLayers().size(), 3);
+    EXPECT_EQ(map.getFilter("points").value(), R"(["==", "foo", "bar"])");
+
+    EXPECT_THROW(map.commitBatch(), std::runtime_error);
+
+    // discarded batches are not applied
+    map.beginBatch();
+    map.setVisibility("box", true);
+    map.discardBatch();
+    EXPECT_EQ(map.getVisibility("box"), false);
+}
+
+TEST(Wrapper, StyleBatchInvalid) {
+    Map map = Map(read_style("example-style-geojson.json"), 10, 10);
+
+    // an invalid operation prevents all operations from being applied
+    map.beginBatch();
+    map.setPaintProperty("box", "fill-opacity", "0.75");
+    map.setVisibility("invalid_layer", false);
+    EXPECT_THROW(map.commitBatch(), std::runtime_error);
+    EXPECT_FALSE(map.isBatching());
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.5");
+
+    map.beginBatch();
+    map.setPaintProperty("box", "fill-opacity", "0.75");
+    map.setPaintProperty("box", "fill-color", "\"not a color\"");
+    EXPECT_THROW(map.commitBatch(), std::runtime_error);
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.5");
+}
+
+TEST(Wrapper, ApplyStyleOperations) {
+    Map map = Map(read_style("example-style-geojson.json"), 10, 10);
+
+    map.applyStyleOperations({
+        {"setPaintProperty", {"box", "fill-opacity", "0.75"}},
+        {"setVisibility", {"box-outline", "false"}},
+        {"setFilter", {"box", R"(["==", "foo", "bar"])"}},
+    });
+
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.75");
+    EXPECT_EQ(map.getVisibility("box-outline"), false);
+    EXPECT_EQ(map.getFilter("box").value(), R"(["==", "foo", "bar"])");
+
+    map.applyStyleOperations({{"setFilter", {"box", ""}}});
+    EXPECT_FALSE(map.getFilter("box").has_value());
+
+    EXPECT_THROW(map.applyStyleOperations({{"invalid", {}}}), std::invalid_argument);
+    EXPECT_THROW(map.applyStyleOperations({{"setVisibility", {"box"}}}), std::invalid_argument);
+    EXPECT_THROW(map.applyStyleOperations({{"setVisibility", {"box", "maybe"}}}),
+                 std::invalid_argument);
+}
+
+TEST(Wrapper, SetStyle) {
+    Map map = Map(read_style("example-style-geojson.json"), 10, 10);
+    map.setPaintProperty("box", "fill-opacity", "0.75");
+
+    // layers that differ from the new style are replaced, including layers
+    // modified after the style was loaded
+    map.setStyle(read_style("example-style-geojson-hidden-box.json"));
+    auto layers = map.listLayers();
+    EXPECT_EQ(layers.size(), 3);
+    EXPECT_EQ(layers[0], "box");
+    EXPECT_EQ(layers[1], "box2");
+    EXPECT_EQ(layers[2], "box-outline");
+    EXPECT_EQ(map.getPaintProperty("box", "fill-opacity").value(), "0.5");
+    EXPECT_EQ(map.getVisibility("box2"), false);
+
+    map.setStyle(read_style("example-style-geojson.json"));
+    EXPECT_EQ(map.listLayers().size(), 2);
+
+    // a style that cannot be applied leaves the previous style intact
+    const string duplicate = R"({"version": 8, "sources": {}, "layers": [
+        {"id": "background", "type": "background"},
+        {"id": "background", "type": "background"}]})";
+    EXPECT_THROW(map.setStyle(duplicate), std::invalid_argument);
+    EXPECT_EQ(map.listLayers(), (vector<string>{"box", "box-outline"}));
+    EXPECT_EQ(map.listSources().size(), 1);
+
+    map.setStyle(read_style("example-style-empty.json"), false);
+    EXPECT_EQ(map.listLayers().size(), 0);
+    EXPECT_EQ(map.listSources().size(), 0);
+
+    EXPECT_THROW(map.setStyle("mapbox://styles/mapbox/streets-v11"), std::invalid_argument);
+}
+
+TEST(Wrapper, RenderStats) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    EXPECT_EQ(map.getStats().frames, 0);
+
+    map.renderPNG();
+    auto stats = map.getStats();
+    EXPECT_EQ(stats.frames, 1);
+    EXPECT_GT(stats.last.styleLoad, 0);
+    EXPECT_GT(stats.last.draw, 0);
+    EXPECT_GT(stats.last.readback, 0);
+    EXPECT_GT(stats.last.encode, 0);
+    EXPECT_GE(stats.last.total,
+              stats.last.styleLoad + stats.last.load + stats.last.draw + stats.last.readback
+                  + stats.last.unpremultiply + stats.last.encode - 1e-6);
+
+    // style load is only attributed to the first render; buffers aren't encoded
+    map.renderBuffer();
+    stats = map.getStats();
+    EXPECT_EQ(stats.frames, 2);
+    EXPECT_EQ(stats.last.styleLoad, 0);
+    EXPECT_EQ(stats.last.encode, 0);
+    EXPECT_GT(stats.cumulative.total, stats.last.total);
+
+    map.resetStats();
+    EXPECT_EQ(map.getStats().frames, 0);
+    EXPECT_EQ(map.getStats().cumulative.total, 0);
+}
+
+TEST(Wrapper, ProfileLayers) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    map.setBounds(-125, 37.5, -115, 42.5);
+    map.setVisibility("box-outline", false);
+
+    auto layerTimes = map.profileLayers(1);
+    ASSERT_EQ(layerTimes.size(), 2);
+    EXPECT_EQ(layerTimes[0].first, "box");
+    EXPECT_GE(layerTimes[0].second, 0);
+    EXPECT_EQ(layerTimes[1].first, "box-outline");
+    EXPECT_EQ(layerTimes[1].second, 0);
+
+    // visibility is restored and profiling renders are not counted
+    EXPECT_TRUE(map.getVisibility("box"));
+    EXPECT_FALSE(map.getVisibility("box-outline"));
+    EXPECT_EQ(map.getStats().frames, 0);
+
+    EXPECT_THROW(map.profileLayers(0), std::domain_error);
+}
+
+TEST(Wrapper, ProfileVisibleLayer) {
+    // the box fills a large map, so drawing it takes measurable time
+    Map map = Map(read_style("example-style-geojson.json"), 1024, 1024);
+    map.setBounds(-122, 38.5, -118, 41.5);
+
+    auto layerTimes = map.profileLayers(5);
+    ASSERT_EQ(layerTimes[0].first, "box");
+    EXPECT_GT(layerTimes[0].second, 0);
+}
+
+TEST(Wrapper, MemoryUsage) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    map.setBounds(-125, 37.5, -115, 42.5);
+
+    auto usage = map.memoryUsage();
+    EXPECT_EQ(usage.textures, 0);
+    EXPECT_EQ(usage.images, 0);
+    EXPECT_GT(usage.geoJSON, 0);
+
+    map.addImage("pixel", string(4 * 4 * 4, '\xff'), 4, 4, 1, false);
+    map.renderPNG();
+
+    usage = map.memoryUsage();
+    EXPECT_GT(usage.buffers, 0);
+    EXPECT_GT(usage.bufferCount, 0);
+    EXPECT_EQ(usage.images, 4 * 4 * 4);
+
+    map.setGeoJSON("geojson", R"({"type": "Point", "coordinates": [0, 0]})");
+    EXPECT_EQ(map.memoryUsage().geoJSON, 40);
+
+    // GPU memory is as of the most recent render, so it is not updated until
+    // the resources released by trim are freed while rendering again
+    map.trim(true);
+    EXPECT_EQ(map.memoryUsage().buffers, usage.buffers);
+
+    // loading a new style drops added images
+    map.setStyle(read_style("example-style-empty.json"), false);
+    EXPECT_EQ(map.memoryUsage().images, 0);
+}
+
+TEST(Wrapper, Trim) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    map.setBounds(-125, 37.5, -115, 42.5);
+    auto expected = map.renderBuffer();
+
+    map.trim();
+    map.trim(true);
+
+    // map renders the same after its tiles are released
+    auto img = map.renderBuffer();
+    EXPECT_EQ(memcmp(expected.get(), img.get(), 100 * 100 * 4), 0);
+}
+
+TEST(Wrapper, SourceBounds) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    EXPECT_THROW(map.getSourceBounds("invalid"), std::runtime_error);
+
+    auto bounds = map.getSourceBounds("geojson");
+    ASSERT_TRUE(bounds.has_value());
+    EXPECT_EQ(bounds->west, -125);
+    EXPECT_EQ(bounds->south, 37.5);
+    EXPECT_EQ(bounds->east, -115);
+    EXPECT_EQ(bounds->north, 42.5);
+
+    map.setGeoJSON("geojson", R"({"type": "Point", "coordinates": [10, 20]})");
+    bounds = map.getSourceBounds("geojson");
+    EXPECT_EQ(bounds->west, 10);
+    EXPECT_EQ(bounds->north, 20);
+
+    map.setGeoJSON("geojson", R"({"type": "FeatureCollection", "features": []})");
+    EXPECT_FALSE(map.getSourceBounds("geojson").has_value());
+
+    // extent of mbtiles is read from its metadata once loaded
+    string style = read_style("example-style-mbtiles-vector-source.json");
+    style        = regex_replace(style, regex("mbtiles://"), "mbtiles://" + FIXTURES_PATH);
+    Map tileMap  = Map(style, 100, 100);
+    tileMap.load();
+    bounds = tileMap.getSourceBounds("land");
+    ASSERT_TRUE(bounds.has_value());
+    EXPECT_NEAR(bounds->west, -180, 1e-6);
+    EXPECT_NEAR(bounds->south, -85.051129, 1e-6);
+    EXPECT_NEAR(bounds->east, 180, 1e-6);
+    EXPECT_NEAR(bounds->north, 83.64513, 1e-6);
+}
+
+TEST(Wrapper, TileHasData) {
+    Map map = Map(read_style("example-style-geojson.json"), 256, 256);
+
+    // tile containing the box and tiles far from it
+    EXPECT_TRUE(map.tileHasData(4, 2, 6));
+    EXPECT_FALSE(map.tileHasData(4, 10, 6));
+    EXPECT_FALSE(map.tileHasData(4, 2, 12));
+    EXPECT_TRUE(map.tileHasData(0, 0, 0));
+
+    // box is just beyond the west edge of tile 4/3/6
+    EXPECT_FALSE(map.tileHasData(4, 3, 6, 0));
+    EXPECT_TRUE(map.tileHasData(4, 3, 6, 0.25));
+
+    // sources added later are included
+    map.addSource("world", R"({
+        "type": "geojson",
+        "data": {"type": "MultiPoint", "coordinates": [[100, 20], [120, 30]]}
+    })");
+    EXPECT_TRUE(map.tileHasData(4, 12, 6));
+
+    EXPECT_THROW(map.tileHasData(4, 16, 0), std::invalid_argument);
+    EXPECT_THROW(map.tileHasData(4, 0, 16), std::invalid_argument);
+    EXPECT_THROW(map.tileHasData(4, 0, 0, -1), std::domain_error);
+    EXPECT_THROW(map.tileHasData(30, 0, 0), std::domain_error);
+}
+
+TEST(Wrapper, RenderMany) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+
+    map.setCenter(-121, 41);
+    map.setZoom(5);
+    auto expected = map.renderBuffer();
+
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+
+    auto frames = map.renderMany({{-120, 40, 4}, {-121, 41, 5}, {-120, 40, 4, 90, 30}}, "buffer");
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[1].size(), 100 * 100 * 4);
+    EXPECT_EQ(memcmp(frames[1].data(), expected.get(), 100 * 100 * 4), 0);
+    EXPECT_NE(frames[0], frames[2]);
+
+    // camera is restored
+    EXPECT_NEAR(map.getCenter().first, -120, 1e-6);
+    EXPECT_NEAR(map.getCenter().second, 40, 1e-6);
+    EXPECT_EQ(map.getZoom(), 4);
+    EXPECT_EQ(map.getBearing(), 0);
+    EXPECT_EQ(map.getStats().frames, 4);
+
+    auto pngs = map.renderMany({{-120, 40, 4}});
+    ASSERT_EQ(pngs.size(), 1);
+    EXPECT_EQ(pngs[0].substr(1, 3), "PNG");
+    // frames are encoded by the pipeline, so encoding is in cumulative stats
+    EXPECT_GT(map.getStats().cumulative.encode, 0);
+
+    EXPECT_EQ(map.renderMany({}).size(), 0);
+
+    EXPECT_THROW(map.renderMany({{-120, 40, 4}}, "jpg"), std::invalid_argument);
+
+    // no frames are rendered if any camera is invalid
+    EXPECT_THROW(map.renderMany({{-120, 40, 4}, {-120, 40, 25}}), std::domain_error);
+    EXPECT_THROW(map.renderMany({{-120, 40, 4, 0, 90}}), std::domain_error);
+    EXPECT_THROW(map.renderMany({{-120, 40, 4}, {-120, 91, 4}}), std::domain_error);
+    EXPECT_EQ(map.getStats().frames, 5);
+}
+
+TEST(Wrapper, InterpolateCamera) {
+    const vector<Keyframe> keyframes = {{1, {-120, 40, 4, 350, 0}},
+                                        {3, {-110, 30, 6, 10, 40}},
+                                        {4, {-110, 30, 6, 10, 40}, "ease-in-out"}};
+
+    auto camera = interpolateCamera(keyframes, 0);
+    EXPECT_EQ(camera.longitude, -120);
+    EXPECT_EQ(camera.zoom, 4);
+
+    camera = interpolateCamera(keyframes, 2);
+    EXPECT_DOUBLE_EQ(camera.longitude, -115);
+    EXPECT_DOUBLE_EQ(camera.latitude, 35);
+    EXPECT_DOUBLE_EQ(camera.zoom, 5);
+    EXPECT_DOUBLE_EQ(camera.pitch, 20);
+    // bearing is rotated in the shortest direction
+    EXPECT_NEAR(camera.bearing, 0, 1e-9);
+
+    camera = interpolateCamera(keyframes, 10);
+    EXPECT_EQ(camera.longitude, -110);
+
+    // eased transitions are symmetric about their midpoint
+    const vector<Keyframe> eased = {{0, {0, 0, 0}}, {1, {0, 0, 10}, "ease-in-out"}};
+    EXPECT_LT(interpolateCamera(eased, 0.25).zoom, 2.5);
+    EXPECT_NEAR(interpolateCamera(eased, 0.5).zoom, 5, 1e-3);
+
+    // paths cross the antimeridian if it is shorter
+    const vector<Keyframe> wrapped = {{0, {170, 0, 2}}, {1, {-170, 0, 2}}};
+    EXPECT_NEAR(interpolateCamera(wrapped, 0.25).longitude, 175, 1e-9);
+    EXPECT_NEAR(std::abs(interpolateCamera(wrapped, 0.5).longitude), 180, 1e-9);
+    EXPECT_NEAR(interpolateCamera(wrapped, 0.75).longitude, -175, 1e-9);
+
+    const vector<Keyframe> invalid = {{0, {0, 0, 0}}, {1, {0, 0, 10}, "bounce"}};
+    EXPECT_THROW(interpolateCamera(invalid, 0.5), std::invalid_argument);
+    EXPECT_THROW(interpolateCamera({}, 0), std::invalid_argument);
+}
+
+TEST(Wrapper, RenderPath) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+    auto first = map.renderBuffer();
+
+    map.setCenter(-115, 38);
+    map.setZoom(5);
+    auto last = map.renderBuffer();
+
+    const vector<Keyframe> keyframes = {{0, {-120, 40, 4}}, {1, {-115, 38, 5}, "ease"}};
+
+    vector<string> frames;
+    auto count = map.renderPath(keyframes, 4, [&](const uint8_t *data, size_t size) {
+        frames.emplace_back(reinterpret_cast<const char *>(data), size);
+    });
+    EXPECT_EQ(count, 5);
+    ASSERT_EQ(frames.size(), 5);
+    EXPECT_EQ(frames[0].size(), 100 * 100 * 4);
+    EXPECT_EQ(memcmp(frames[0].data(), first.get(), 100 * 100 * 4), 0);
+    EXPECT_EQ(memcmp(frames[4].data(), last.get(), 100 * 100 * 4), 0);
+
+    // camera is restored
+    EXPECT_NEAR(map.getCenter().first, -115, 1e-6);
+    EXPECT_EQ(map.getZoom(), 5);
+
+    // write to a file descriptor
+    // unique so that concurrent test runs do not write the same file
+    const string filename
+        = (fs::temp_directory_path() / ("render_path_" + to_string(random_device()()) + ".rgba"))
+              .string();
+    FILE *file = fopen(filename.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(map.renderPath(keyframes, 2, fileno(file)), 3);
+    fclose(file);
+    EXPECT_EQ(fs::file_size(filename), 3 * 100 * 100 * 4);
+    fs::remove(filename);
+
+    // errors raised by the callback stop rendering
+    uint32_t calls = 0;
+    EXPECT_THROW(map.renderPath(keyframes,
+                                30,
+                                [&](const uint8_t *, size_t) {
+                                    calls++;
+                                    throw std::runtime_error("callback failed");
+                                }),
+                 std::runtime_error);
+    EXPECT_EQ(calls, 1);
+
+    EXPECT_THROW(map.renderPath(keyframes, 0, [](const uint8_t *, size_t) {}), std::domain_error);
+    EXPECT_THROW(map.renderPath({}, 30, [](const uint8_t *, size_t) {}), std::invalid_argument);
+    EXPECT_THROW(map.renderPath(keyframes, 30, -1), std::invalid_argument);
+    EXPECT_THROW(map.renderPath({{1, {0, 0, 0}}, {0, {0, 0, 0}}},
+                                30,
+                                [](const uint8_t *, size_t) {}),
+                 std::invalid_argument);
+    EXPECT_THROW(map.renderPath({{0, {0, 0, 0}}, {1, {0, 95, 4}}},
+                                30,
+                                [](const uint8_t *, size_t) {}),
+                 std::domain_error);
+    EXPECT_THROW(map.renderPath({{0, {0, 0, 0}}, {1, {0, 0, 25}}},
+                                30,
+                                [](const uint8_t *, size_t) {}),
+                 std::domain_error);
+}
+
+TEST(Wrapper, RenderTiledPNG) {
+    Map map = Map(read_style("example-style-geojson.json"), 500, 300, 2);
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+
+    const string pngFilename = "/tmp/render_tiled_expected.png";
+    write_test_image(map.renderPNG(), "render_tiled_expected.png", false);
+    auto expected = read_image(pngFilename);
+    fs::remove(pngFilename);
+
+    // tiles do not evenly divide the image
+    const string filename = "/tmp/render_tiled.png";
+    map.renderTiledPNG(filename, 500, 300, 128, 32);
+    auto img = read_image(filename);
+    fs::remove(filename);
+
+    ASSERT_EQ(img.size.width, 1000);
+    ASSERT_EQ(img.size.height, 600);
+    auto diff = mapbox::pixelmatch(
+        img.data.get(), expected.data.get(), 1000, 600, nullptr, 0.1285);
+    EXPECT_LT(diff, 1000 * 600 / 1000);
+
+    // size and camera are restored
+    EXPECT_EQ(map.getSize(), make_pair(500u, 300u));
+    EXPECT_NEAR(map.getCenter().first, -120, 1e-6);
+
+    EXPECT_THROW(map.renderTiledPNG(filename, 500, 300, 0), std::domain_error);
+    EXPECT_THROW(map.renderTiledPNG("/invalid/render_tiled.png", 500, 300), std::runtime_error);
+
+    map.setBearing(90);
+    EXPECT_THROW(map.renderTiledPNG(filename, 500, 300), std::runtime_error);
+}
+
+TEST(Wrapper, RenderTiledPNGFractionalRatio) {
+    Map map = Map(read_style("example-style-geojson.json"), 500, 300, 1.5);
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+
+    const string pngFilename = "/tmp/render_tiled_fractional_expected.png";
+    write_test_image(map.renderPNG(), "render_tiled_fractional_expected.png", false);
+    auto expected = read_image(pngFilename);
+    fs::remove(pngFilename);
+
+    // tile edges and overlap fall within output pixels
+    const string filename = "/tmp/render_tiled_fractional.png";
+    map.renderTiledPNG(filename, 500, 300, 101, 33);
+    auto img = read_image(filename);
+    fs::remove(filename);
+
+    ASSERT_EQ(img.size.width, 750);
+    ASSERT_EQ(img.size.height, 450);
+    auto diff = mapbox::pixelmatch(img.data.get(), expected.data.get(), 750, 450, nullptr, 0.1285);
+    EXPECT_LT(diff, 750 * 450 / 1000);
+}
+
+TEST(Wrapper, RenderTiles) {
+    Map map = Map(read_style("example-style-geojson.json"), 256, 256);
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+
+    const string filename = "/tmp/render_tiles.mbtiles";
+    fs::remove(filename);
+    MBTilesWriter writer(filename, 2);
+
+    // tiles that contain the box and the first empty tile of each zoom are
+    // rendered; other empty tiles are written with the image of the first
+    const vector<TileID> tiles{{1, 0, 0}, {1, 1, 0}, {1, 0, 1}, {1, 1, 1}, {4, 2, 6}, {4, 10, 6}};
+    EXPECT_EQ(map.renderTiles(tiles, writer, true, 0), 6);
+    EXPECT_EQ(writer.getTileCount(), 6);
+    EXPECT_EQ(map.getStats().frames, 4);
+
+    // empty tiles are all transparent and share one image
+    EXPECT_EQ(map.renderTiles({{4, 10, 6}, {4, 11, 6}}, writer, false), 2);
+    EXPECT_EQ(writer.getTileCount(), 8);
+    EXPECT_EQ(writer.getImageCount(), 3);
+
+    // empty tiles show the background, which is rendered once per zoom
+    map.addLayer(
+        R"({"id": "background", "type": "background", "paint": {"background-color": "#0000FF"}})");
+    map.resetStats();
+    EXPECT_EQ(map.renderTiles({{4, 12, 6}, {4, 13, 6}, {4, 14, 6}}, writer, true, 0), 3);
+    EXPECT_EQ(map.getStats().frames, 1);
+    EXPECT_EQ(writer.getTileCount(), 11);
+    EXPECT_EQ(writer.getImageCount(), 4);
+
+    // camera is restored
+    EXPECT_NEAR(map.getCenter().first, -120, 1e-6);
+    EXPECT_NEAR(map.getZoom(), 4, 1e-6);
+
+    // tiles of zoom 0 are 512 pixels across
+    EXPECT_THROW(map.renderTiles({{0, 0, 0}}, writer), std::domain_error);
+    EXPECT_THROW(map.renderTiles({{1, 2, 0}}, writer), std::invalid_argument);
+    EXPECT_THROW(map.renderTiles({{1, 0, 0}}, writer, true, -1), std::domain_error);
+
+    map.setSize(256, 128);
+    EXPECT_THROW(map.renderTiles({{1, 0, 0}}, writer), std::runtime_error);
+
+    writer.close();
+    fs::remove(filename);
+}
+
+TEST(Wrapper, RenderTilesPMTiles) {
+    Map map = Map(read_style("example-style-geojson.json"), 256, 256);
+
+    const string filename = "/tmp/render_tiles.pmtiles";
+    PMTilesWriter writer(filename);
+
+    // tiles may be rendered in any order
+    EXPECT_EQ(map.renderTiles({{4, 11, 6}, {4, 10, 6}, {1, 0, 0}}, writer, false), 3);
+    EXPECT_EQ(writer.getTileCount(), 3);
+    EXPECT_EQ(writer.getImageCount(), 2);
+    writer.close();
+
+    std::ifstream file(filename, std::ios::binary);
+    string header(8, '\0');
+    file.read(header.data(), header.size());
+    EXPECT_EQ(header, string("PMTiles\x03", 8));
+    file.close();
+
+    EXPECT_THROW(map.renderTiles({{1, 0, 0}}, writer), std::runtime_error);
+
+    fs::remove(filename);
+}
+
+TEST(Wrapper, RenderWithInfo) {
+    Map map = Map(read_style("example-style-empty.json"), 100, 50);
+    map.addLayer(
+        R"({"id": "background", "type": "background", "paint": {"background-color": "#0000FF"}})");
+
+    auto expected = map.renderBuffer();
+
+    auto info = map.renderWithInfo();
+    ASSERT_TRUE(info.uniformColor.has_value());
+    EXPECT_EQ(*info.uniformColor, (Color{0, 0, 255, 255}));
+    EXPECT_EQ(info.hash,
+              xxhash64(reinterpret_cast<const uint8_t *>(info.data.data()), info.data.size()));
+
+    // palette PNG decodes to the same pixels
+    auto img = mbgl::decodeImage(info.data);
+    ASSERT_EQ(img.size, mbgl::Size(100, 50));
+    EXPECT_EQ(memcmp(img.data.get(), expected.get(), img.bytes()), 0);
+
+    // cached PNG is reused
+    EXPECT_EQ(map.renderWithInfo().data, info.data);
+
+    auto buffer = map.renderWithInfo("buffer");
+    ASSERT_EQ(buffer.data.size(), 100 * 50 * 4);
+    EXPECT_EQ(memcmp(buffer.data.data(), expected.get(), buffer.data.size()), 0);
+
+    // transparent colors are unpremultiplied
+    map.setPaintProperty("background", "background-color", R"("rgba(0, 0, 255, 0.5)")");
+    info = map.renderWithInfo();
+    ASSERT_TRUE(info.uniformColor.has_value());
+    EXPECT_EQ((*info.uniformColor)[2], 255);
+    EXPECT_NEAR((*info.uniformColor)[3], 128, 1);
+
+    Map geojsonMap = Map(read_style("example-style-geojson.json"), 100, 50);
+    geojsonMap.setBounds(-125, 37.5, -115, 42.5);
+    info = geojsonMap.renderWithInfo();
+    EXPECT_FALSE(info.uniformColor.has_value());
+    EXPECT_EQ(info.data, geojsonMap.renderPNG());
+    EXPECT_NE(info.hash, 0);
+
+    EXPECT_THROW(map.renderWithInfo("jpg"), std::invalid_argument);
+}
+
+TEST(Wrapper, SetPixelRatio) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 50);
+    map.setBounds(-125, 37.5, -115, 42.5);
+    map.setPaintProperty("box", "fill-color", R"("#FF0000")");
+    map.addSource("point", R"({
+        "type": "geojson",
+        "data": {"type": "Point", "coordinates": [-120, 40]}
+    })");
+    map.addLayer(
+        R"({"id": "point", "type": "circle", "source": "point", "paint": {"circle-radius": 5}})");
+    map.render();
+
+    map.setPixelRatio(2);
+    EXPECT_EQ(map.getPixelRatio(), 2);
+    EXPECT_EQ(map.getSize(), make_pair(100u, 50u));
+    EXPECT_NEAR(map.getCenter().first, -120, 1e-6);
+
+    // changes to the style are kept
+    auto layers = map.listLayers();
+    EXPECT_EQ(layers.back(), "point");
+    EXPECT_EQ(map.getPaintProperty("box", "fill-color").value(), R"("#FF0000")");
+
+    // same as a map created at the ratio
+    Map expectedMap = Map(read_style("example-style-geojson.json"), 100, 50, 2);
+    expectedMap.setBounds(-125, 37.5, -115, 42.5);
+    expectedMap.setPaintProperty("box", "fill-color", R"("#FF0000")");
+    expectedMap.addSource("point", R"({
+        "type": "geojson",
+        "data": {"type": "Point", "coordinates": [-120, 40]}
+    })");
+    expectedMap.addLayer(
+        R"({"id": "point", "type": "circle", "source": "point", "paint": {"circle-radius": 5}})");
+
+    auto img      = map.renderBuffer();
+    auto expected = expectedMap.renderBuffer();
+    auto diff     = mapbox::pixelmatch(img.get(), expected.get(), 200, 100, nullptr, 0.1285);
+    EXPECT_EQ(diff, 0);
+
+    EXPECT_THROW(map.setPixelRatio(0), std::domain_error);
+    EXPECT_THROW(map.setPixelRatio(9), std::domain_error);
+
+    map.beginBatch();
+    EXPECT_THROW(map.setPixelRatio(1), std::runtime_error);
+    map.discardBatch();
+}
+
+TEST(Wrapper, RenderAtRatios) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 50);
+    map.setBounds(-125, 37.5, -115, 42.5);
+
+    auto expected = map.renderBuffer();
+
+    auto frames = map.renderAtRatios({2, 1}, "buffer");
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[0].size(), 200 * 100 * 4);
+    EXPECT_EQ(frames[1].size(), 100 * 50 * 4);
+    EXPECT_EQ(memcmp(frames[1].data(), expected.get(), frames[1].size()), 0);
+
+    // pixel ratio is restored
+    EXPECT_EQ(map.getPixelRatio(), 1);
+
+    auto pngs = map.renderAtRatios({1, 3});
+    EXPECT_EQ(pngs[1].substr(1, 3), "PNG");
+
+    // frames are returned in order of ratios, and the style is restored
+    map.addLayer(R"({"id": "outline", "type": "line", "source": "geojson"})");
+    frames = map.renderAtRatios({2, 1, 3, 2}, "buffer");
+    ASSERT_EQ(frames.size(), 4);
+    EXPECT_EQ(frames[1].size(), 100 * 50 * 4);
+    EXPECT_EQ(frames[2].size(), 300 * 150 * 4);
+    EXPECT_EQ(frames[0], frames[3]);
+    EXPECT_EQ(map.getPixelRatio(), 1);
+    EXPECT_EQ(map.listLayers(), (vector<string>{"box", "box-outline", "outline"}));
+    EXPECT_EQ(memcmp(frames[1].data(), map.renderBuffer().get(), frames[1].size()), 0);
+
+    EXPECT_THROW(map.renderAtRatios({1, 0}), std::domain_error);
+    EXPECT_THROW(map.renderAtRatios({1}, "jpg"), std::invalid_argument);
+}
+
+TEST(Wrapper, RenderRegion) {
+    Map map = Map(read_style("example-style-geojson.json"), 400, 300, 2);
+    map.setCenter(-120, 40);
+    map.setZoom(4);
+    map.setBearing(30);
+
+    auto full = map.renderBuffer();
+
+    // crop the same region from the full render, in output pixels
+    const uint32_t x = 120, y = 40, width = 200, height = 150;
+    vector<uint8_t> expected(size_t(width) * height * 4 * 4);
+    for (uint32_t row = 0; row < height * 2; row++) {
+        memcpy(expected.data() + size_t(row) * width * 2 * 4,
+               full.get() + (size_t(row + y * 2) * 800 + x * 2) * 4,
+               size_t(width) * 2 * 4);
+    }
+
+    auto region = map.renderRegion(x, y, width, height, "buffer");
+    ASSERT_EQ(region.size(), expected.size());
+    auto diff = mapbox::pixelmatch(reinterpret_cast<const uint8_t *>(region.data()),
+                                   expected.data(),
+                                   width * 2,
+                                   height * 2,
+                                   nullptr,
+                                   0.1285);
+    EXPECT_LT(diff, width * height * 4 / 1000);
+
+    // size and camera are restored
+    EXPECT_EQ(map.getSize(), make_pair(400u, 300u));
+    EXPECT_NEAR(map.getCenter().first, -120, 1e-6);
+    EXPECT_NEAR(map.getCenter().second, 40, 1e-6);
+
+    auto png = map.renderRegion(0, 0, 400, 300);
+    EXPECT_EQ(png.substr(1, 3), "PNG");
+
+    EXPECT_THROW(map.renderRegion(0, 0, 0, 100), std::domain_error);
+    EXPECT_THROW(map.renderRegion(300, 0, 101, 100), std::invalid_argument);
+    EXPECT_THROW(map.renderRegion(0, 0, 100, 100, "jpg"), std::invalid_argument);
+
+    map.setPitch(30);
+    EXPECT_THROW(map.renderRegion(0, 0, 100, 100), std::runtime_error);
+}
+
+TEST(Wrapper, RenderPNGToFile) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 100);
+    map.setBounds(-125, 37.5, -115, 42.5);
+
+    write_test_image(map.renderPNG(), "render_png_to_file_expected.png", false);
+    auto expected = read_image("/tmp/render_png_to_file_expected.png");
+
+    const string filename = "/tmp/render_png_to_file.png";
+    map.renderPNGToFile(filename);
+    auto img = read_image(filename);
+    ASSERT_EQ(img.size, expected.size);
+    EXPECT_EQ(memcmp(img.data.get(), expected.data.get(), img.bytes()), 0);
+    EXPECT_GT(map.getStats().last.encode, 0);
+
+    // write to a file descriptor, which is left open
+    FILE *file = fopen(filename.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    map.renderPNGToFile(fileno(file));
+    fclose(file);
+    img = read_image(filename);
+    EXPECT_EQ(memcmp(img.data.get(), expected.data.get(), img.bytes()), 0);
+
+    fs::remove(filename);
+    fs::remove("/tmp/render_png_to_file_expected.png");
+
+    EXPECT_THROW(map.renderPNGToFile("/invalid/render_png_to_file.png"), std::runtime_error);
+    EXPECT_THROW(map.renderPNGToFile(-1), std::invalid_argument);
+}
+
+TEST(Wrapper, RenderToSharedMemory) {
+    Map map = Map(read_style("example-style-geojson.json"), 100, 50);
+    map.setBounds(-125, 37.5, -115, 42.5);
+
+    auto expected = map.renderBuffer();
+
+    const string name = "/pymgl-wrapper-test";
+    EXPECT_EQ(map.renderToSharedMemory(name), 2);
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    ASSERT_GE(fd, 0);
+    struct stat info;
+    ASSERT_EQ(fstat(fd, &info), 0);
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(mapped, MAP_FAILED);
+
+    auto header = static_cast<const SharedFrameHeader *>(mapped);
+    EXPECT_EQ(header->width, 100);
+    EXPECT_EQ(header->height, 50);
+    EXPECT_EQ(header->pixelRatio, 1);
+    EXPECT_EQ(memcmp(static_cast<const uint8_t *>(mapped) + header->dataOffset,
+                     expected.get(),
+                     100 * 50 * 4),
+              0);
+    munmap(mapped, info.st_size);
+
+    EXPECT_EQ(map.renderToSharedMemory(name), 4);
+    EXPECT_GT(map.getStats().last.unpremultiply, 0);
+
+    shm_unlink(name.c_str());
+
+    EXPECT_THROW(map.renderToSharedMemory(""), std::invalid_argument);
+    EXPECT_THROW(map.renderToSharedMemory("pymgl/frame"), std::invalid_argument);
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "map.h"
+#include "util.h"
+
+// Soak test that repeatedly mutates and renders maps, recycling them
+// periodically, while sampling resident memory, GPU objects, and open file
+// descriptors.  Fails if any of these are still growing after a warmup.
+//
+// Must be run from the root directory so that fixtures are found.
+
+using namespace mgl_wrapper;
+using namespace testing;
+using namespace std;
+
+namespace {
+
+struct Options {
+    uint64_t iterations = 10000;
+    // create a new map after this many iterations
+    uint64_t recycle = 500;
+    // sample resources every this many iterations
+    uint64_t sampleEvery = 100;
+    // fraction of samples ignored while caches fill
+    double warmup = 0.2;
+    // allowed growth in resident memory after warmup, in MB
+    double maxRSSGrowth = 32;
+    string csv;
+};
+
+struct Sample {
+    uint64_t iteration;
+    double rss;
+    uint32_t textures;
+    uint32_t buffers;
+    uint32_t framebuffers;
+    uint32_t fds;
+};
+
+void usage() {
+    cout << "usage: pymgl_soak [--iterations N] [--recycle N] [--sample-every N] [--warmup F]"
+         << " [--max-rss-growth MB] [--csv FILENAME]" << endl;
+}
+
+// Resident memory in MB
+double residentMemory() {
+    ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return double(resident) * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+uint32_t openFiles() {
+    uint32_t count = 0;
+    for (const auto &entry : filesystem::directory_iterator("/proc/self/fd")) {
+        (void)entry;
+        count++;
+    }
+    return count;
+}
+
+// Return a FeatureCollection of count boxes with feature IDs, offset by
+// iteration so that data changes each time it is set
+string makeBoxes(uint64_t iteration, uint32_t count) {
+    ostringstream out;
+    out << R"({"type": "FeatureCollection", "features": [)";
+    for (uint32_t i = 0; i < count; i++) {
+        const double x = -125 + (i % 10) + (iteration % 7) * 0.1;
+        const double y = 37.5 + (i / 10) * 0.5;
+        out << (i ? "," : "") << R"({"type": "Feature", "id": )" << i
+            << R"(, "properties": {}, "geometry": {"type": "Polygon", "coordinates": [[)"
+            << "[" << x << "," << y << "],[" << x + 0.8 << "," << y << "],[" << x + 0.8 << ","
+            << y + 0.4 << "],[" << x << "," << y + 0.4 << "],[" << x << "," << y << "]]]}}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+double median(vector<double> values) {
+    sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+// Compare medians of the first and last quarters of samples after warmup, so
+// that single samples do not cause false failures
+template <typename Value>
+pair<double, double> growth(const vector<Sample> &samples, size_t first, Value value) {
+    const size_t quarter = max<size_t>((samples.size() - first) / 4, 1);
+    vector<double> start, end;
+    for (size_t i = first; i < first + quarter; i++) {
+        start.push_back(value(samples[i]));
+    }
+    for (size_t i = samples.size() - quarter; i < samples.size(); i++) {
+        end.push_back(value(samples[i]));
+    }
+    return {median(start), median(end)};
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        const string value = argv[++i];
+        if (arg == "--iterations") {
+            options.iterations = stoull(value);
+        } else if (arg == "--recycle") {
+            options.recycle = stoull(value);
+        } else if (arg == "--sample-every") {
+            options.sampleEvery = stoull(value);
+        } else if (arg == "--warmup") {
+            options.warmup = stod(value);
+        } else if (arg == "--max-rss-growth") {
+            options.maxRSSGrowth = stod(value);
+        } else if (arg == "--csv") {
+            options.csv = value;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (options.recycle == 0 || options.sampleEvery == 0
+        || options.iterations < options.sampleEvery * 8) {
+        cerr << "iterations must be at least 8 times sample-every, and recycle must be > 0"
+             << endl;
+        return 2;
+    }
+
+    const string style = read_style("example-style-geojson-features.json");
+    const string marker(16 * 16 * 4, '\x7f');
+    const uint32_t sizes[][2] = {{256, 256}, {512, 256}, {300, 600}};
+
+    vector<Sample> samples;
+    unique_ptr<Map> map;
+
+    cout << setw(10) << "iteration" << setw(10) << "rss (MB)" << setw(10) << "textures"
+         << setw(10) << "buffers" << setw(14) << "framebuffers" << setw(6) << "fds" << endl;
+
+    for (uint64_t i = 0; i < options.iterations; i++) {
+        if (i % options.recycle == 0) {
+            map.reset();
+            map = make_unique<Map>(style, 256, 256);
+            map->setBounds(-125, 37.5, -115, 42.5);
+        }
+
+        switch (i % 4) {
+        case 0:
+            map->setGeoJSON("geojson", makeBoxes(i, 50));
+            break;
+        case 1:
+            map->setFeatureState("geojson", "box", to_string(i % 50),
+                                 i % 2 ? R"({"selected": true})" : R"({"selected": false})");
+            break;
+        case 2: {
+            const auto &size = sizes[(i / 4) % 3];
+            map->setSize(size[0], size[1]);
+            break;
+        }
+        case 3:
+            // replaces one of a few images, so images held should not grow
+            map->addImage("marker-" + to_string(i % 5), marker, 16, 16, 1, false);
+            break;
+        }
+
+        map->renderBuffer();
+
+        if ((i + 1) % options.sampleEvery == 0) {
+            const MemoryUsage usage = map->memoryUsage();
+            Sample sample{i + 1,
+                          residentMemory(),
+                          usage.textureCount,
+                          usage.bufferCount,
+                          usage.framebufferCount,
+                          openFiles()};
+            samples.push_back(sample);
+
+            cout << setw(10) << sample.iteration << setw(10) << fixed << setprecision(1)
+                 << sample.rss << setw(10) << sample.textures << setw(10) << sample.buffers
+                 << setw(14) << sample.framebuffers << setw(6) << sample.fds << endl;
+        }
+    }
+    map.reset();
+
+    if (!options.csv.empty()) {
+        ofstream csv(options.csv);
+        csv << "iteration,rss_mb,textures,buffers,framebuffers,fds\n";
+        for (const auto &sample : samples) {
+            csv << sample.iteration << "," << sample.rss << "," << sample.textures << ","
+                << sample.buffers << "," << sample.framebuffers << "," << sample.fds << "\n";
+        }
+    }
+
+    const size_t first = min(size_t(samples.size() * options.warmup), samples.size() - 4);
+
+    bool failed = false;
+    auto check  = [&](const string &name, pair<double, double> values, double allowed) {
+        const bool grew = values.second - values.first > allowed;
+        cout << (grew ? "FAIL " : "ok   ") << name << ": " << values.first << " -> "
+             << values.second << " (allowed growth " << allowed << ")" << endl;
+        failed = failed || grew;
+    };
+
+    cout << endl;
+    check("rss (MB)", growth(samples, first, [](const Sample &s) { return s.rss; }),
+          options.maxRSSGrowth);
+    // GPU object counts depend on the map size and tiles drawn, which vary
+    // between iterations, so allow some variation
+    check("textures", growth(samples, first, [](const Sample &s) { return s.textures; }), 2);
+    check("buffers",
+          growth(samples, first, [](const Sample &s) { return s.buffers; }),
+          max(8.0, samples[first].buffers * 0.1));
+    check("framebuffers",
+          growth(samples, first, [](const Sample &s) { return s.framebuffers; }),
+          1);
+    check("fds", growth(samples, first, [](const Sample &s) { return s.fds; }), 1);
+
+    return failed ? 1 : 0;
+}